@@ -0,0 +1,423 @@
+#pragma once
+#include "plugin.hpp"
+#include "SpscRingBuffer.hpp"
+#include "HutaraDsp.hpp"
+#include "ModMatrix.hpp"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+// The four oscillators as one structure-of-arrays bank, lane order follows the
+// SINE, SAW, TRIANGLE, SQUARE order of the param, input and output ids
+struct OscillatorBank {
+    simd::float_4 phase = 0.f;
+    simd::float_4 increment = 0.f;
+    simd::float_4 volume = 0.f;
+    simd::float_4 shaperAmount = 0.f;
+};
+
+struct FmOperator : Module {
+    // One bank per polyphonic voice
+    OscillatorBank banks[PORT_MAX_CHANNELS];
+    const float fmScale = 32.23;
+    
+    const float psychedelicCVKnobScale = 5.0f;  // Adjust the scale as needed
+    float psychedelicCVKnobValue = 0.0f;
+
+    // The mandala only needs its brightness at UI rate
+    dsp::ClockDivider lightDivider;
+    float lightPeak = 0.f;
+
+    // Stereo mix of the four oscillators, pan gains follow the knobs at control rate
+    hutara::StereoBus stereoBus;
+    dsp::ClockDivider panDivider;
+
+    // On-panel scope, fed with FINAL_OUTPUT averaged over SCOPE_DECIMATION samples.
+    // Only the audio thread pushes and only the scope widget pops.
+    static const int SCOPE_DECIMATION = 4;
+    bool scopeEnabled = false;
+    SpscRingBuffer<float, 4096> scopeBuffer;
+    float scopeAccumulator = 0.f;
+    int scopeCounter = 0;
+
+    enum ParamId {
+        PITCH_PARAM_SINE,
+        PITCH_PARAM_SAW,
+        PITCH_PARAM_TRIANGLE,
+        PITCH_PARAM_SQUARE,
+        FM_PARAM,
+        SINE_WAVESHAPER_PARAM, 
+        SAW_WAVESHAPER_PARAM,
+        PSYCHEDELIC_PARAM_TRIANGLE,
+        PSYCHEDELIC_CV_KNOB_PARAM,
+        FM_AMOUNT_PARAM,
+        VOLUME_PARAM_SINE,
+        VOLUME_PARAM_SAW,
+        VOLUME_PARAM_TRIANGLE,
+        VOLUME_PARAM_SQUARE,
+        RESAMPLE,
+        PAN_PARAM_SINE,
+        PAN_PARAM_SAW,
+        PAN_PARAM_TRIANGLE,
+        PAN_PARAM_SQUARE,
+        ATTACK_PARAM,
+        RELEASE_PARAM,
+        PARAMS_LEN
+    };
+
+    enum InputId {
+        PITCH_INPUT_SINE,
+        PITCH_INPUT_SAW,
+        PITCH_INPUT_TRIANGLE,
+        PITCH_INPUT_SQUARE,
+        FM_INPUT,
+        FM_AMOUNT_INPUT,
+        PSYCHEDELIC_CV_INPUT_SAW,
+        PSYCHEDELIC_CV_INPUT_FOR_All,
+        PSYCHEDELIC_CV_INPUT_TRIANGLE,
+        RESAMPLE_INPUT, 
+        PITCH_INPUT_ALL,
+        MOD_TRIGGER_INPUT,
+        GATE_INPUT,
+        VELOCITY_INPUT,
+        INPUTS_LEN
+    };
+
+    enum OutputId {
+        SINE_OUTPUT,
+        SAW_OUTPUT,
+        TRIANGLE_OUTPUT,
+        SQUARE_OUTPUT,
+        FINAL_OUTPUT,
+        LEFT_OUTPUT,
+        RIGHT_OUTPUT,
+        OUTPUTS_LEN,
+    };
+    enum LightId {
+        FINAL_OUTPUT_LIGHT,  // Existing light ID
+        LIGHTS_LEN
+    };
+
+    // Internal LFOs and envelopes, evaluated every MOD_DIVISION samples into
+    // modOffsets, which paramValue() adds to the knobs
+    static const int MOD_DIVISION = 32;
+    ModMatrix modMatrix;
+    dsp::ClockDivider modDivider;
+    hutara::EdgeDetector<float> modTrigger;
+    float modOffsets[PARAMS_LEN] = {};
+
+    // Per-voice amplitude envelopes, four voices per float_4 group. A voice that
+    // stays under IDLE_THRESHOLD for IDLE_TIME is idle and skipped entirely;
+    // activeVoices lists the others densely each sample.
+    static constexpr float IDLE_THRESHOLD = 1e-3f;
+    static constexpr float IDLE_TIME = 0.1f;
+    static const int VOICE_GROUPS = PORT_MAX_CHANNELS / 4;
+    hutara::EdgeDetector<simd::float_4> voiceGates[VOICE_GROUPS];
+    // float_4 is left uninitialized by its default constructor, so zero these
+    // for patches that load with Gate already connected
+    simd::float_4 voiceLevels[VOICE_GROUPS] = {};
+    simd::float_4 voiceQuietTimes[VOICE_GROUPS] = {};
+    bool voiceIdle[PORT_MAX_CHANNELS] = {};
+    int activeVoices[PORT_MAX_CHANNELS];
+    int activeCount = 0;
+
+    FmOperator() {
+        config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
+        configInput(PITCH_INPUT_ALL, "Pitch CV for All Osc");
+        configInput(MOD_TRIGGER_INPUT, "Modulation Envelope Trigger");
+        configInput(GATE_INPUT, "Gate");
+        configInput(VELOCITY_INPUT, "Velocity");
+        configParam(PSYCHEDELIC_CV_KNOB_PARAM, -0.5f, 1.f, 0.f, "Psychedelic CV");
+        configParam(PITCH_PARAM_SINE, -4.f, 4.f, 0.f, "Sine Pitch");
+        configParam(PITCH_PARAM_SAW, -4.f, 4.f, 0.f, "Saw Pitch");
+        configParam(PITCH_PARAM_TRIANGLE, -4.f, 4.f, 0.f, "Triangle Pitch");
+        configParam(PITCH_PARAM_SQUARE, -4.f, 4.f, 0.f, "SQUARE Pitch");
+        configParam(FM_PARAM, -0.7, 1.23, 0.f, "FM Input");
+        configParam(SINE_WAVESHAPER_PARAM, -0.5, 1.5f, 0.f, "Sine Waveshaper");
+        configParam(SAW_WAVESHAPER_PARAM, -0.5f, 1.f, 0.f, "Saw Psychedelic");
+        configInput(PSYCHEDELIC_CV_INPUT_FOR_All, "CV_INPUT_FOR_All");
+        configParam(PSYCHEDELIC_PARAM_TRIANGLE, -0.5f, 1.f, 0.f, "Triangle Psychedelic");
+        configParam(FM_AMOUNT_PARAM, -0.5f, 0.6f, 0.f, "FM Amount");
+        configParam(VOLUME_PARAM_SINE, 0.f, 1.f, 1.f, "Sine Volume");
+        configParam(VOLUME_PARAM_SAW, 0.f, 1.f, 1.f, "Saw Volume");
+        configParam(VOLUME_PARAM_TRIANGLE, 0.f, 1.f, 1.f, "Triangle Volume");
+        configParam(VOLUME_PARAM_SQUARE, 0.f, 1.f, 1.f, "SQUARE Volume");
+        configParam(RESAMPLE, 0.0f, 0.8f, 0.8f, "Resample");
+        configParam(PAN_PARAM_SINE, -1.f, 1.f, 0.f, "Sine Pan");
+        configParam(PAN_PARAM_SAW, -1.f, 1.f, 0.f, "Saw Pan");
+        configParam(PAN_PARAM_TRIANGLE, -1.f, 1.f, 0.f, "Triangle Pan");
+        configParam(PAN_PARAM_SQUARE, -1.f, 1.f, 0.f, "SQUARE Pan");
+        configParam(ATTACK_PARAM, 0.001f, 2.f, 0.005f, "Gate Attack", " s");
+        configParam(RELEASE_PARAM, 0.001f, 5.f, 0.3f, "Gate Release", " s");
+        configInput(RESAMPLE_INPUT, "RESAMPLE Input");
+        configInput(PITCH_INPUT_SINE, "Sine Pitch CV");
+        configInput(PITCH_INPUT_SAW, "Saw Pitch CV");
+        configInput(PITCH_INPUT_TRIANGLE, "Triangle Pitch CV");
+        configInput(PITCH_INPUT_SQUARE, "SQUARE Pitch CV");
+        configInput(FM_INPUT, "FM CV");
+        configInput(FM_AMOUNT_INPUT, "FM Amount CV");
+        configInput(PSYCHEDELIC_CV_INPUT_SAW, "Saw Psychedelic CV");
+        configInput(PSYCHEDELIC_CV_INPUT_TRIANGLE, "Triangle WaveShaper CV");
+        configOutput(SINE_OUTPUT, "Sine Output");
+        configOutput(SAW_OUTPUT, "Saw Output");
+        configOutput(TRIANGLE_OUTPUT, "Triangle Output");
+        configOutput(SQUARE_OUTPUT, "SQUARE Output");
+        configOutput(FINAL_OUTPUT, "Resampling Output");
+        configOutput(LEFT_OUTPUT, "Resampling Output Left");
+        configOutput(RIGHT_OUTPUT, "Resampling Output Right");
+        configLight(FINAL_OUTPUT_LIGHT, "Resampling Output level");
+        lightDivider.setDivision(512);
+        panDivider.setDivision(16);
+        modDivider.setDivision(MOD_DIVISION);
+    }
+    
+    float paramValue(int id) {
+        return params[id].getValue() + modOffsets[id];
+    }
+
+    void processModulation(const ProcessArgs &args) {
+        if (inputs[MOD_TRIGGER_INPUT].isConnected() && modTrigger.process(inputs[MOD_TRIGGER_INPUT].getVoltage()) > 0.f)
+            modMatrix.trigger();
+        if (!modDivider.process())
+            return;
+
+        float amounts[PARAMS_LEN] = {};
+        modMatrix.process(args.sampleTime * MOD_DIVISION, amounts);
+        for (int id = 0; id < PARAMS_LEN; ++id) {
+            // Unmodulated params keep a zero offset, so only routed ones cost anything
+            if (amounts[id] == 0.f && modOffsets[id] == 0.f)
+                continue;
+            ParamQuantity* pq = paramQuantities[id];
+            float value = params[id].getValue();
+            float range = pq->getMaxValue() - pq->getMinValue();
+            float modulated = clamp(value + amounts[id] * range, pq->getMinValue(), pq->getMaxValue());
+            modOffsets[id] = modulated - value;
+        }
+    }
+
+    // Advances the voice envelopes and rebuilds activeVoices
+    void processVoiceLevels(const ProcessArgs &args, int channels) {
+        using simd::float_4;
+
+        activeCount = 0;
+
+        // Without a gate every voice plays at full level, as before the envelopes existed
+        if (!inputs[GATE_INPUT].isConnected()) {
+            for (int g = 0; g < VOICE_GROUPS; ++g) {
+                voiceLevels[g] = 1.f;
+                voiceQuietTimes[g] = 0.f;
+            }
+            for (int c = 0; c < channels; ++c) {
+                voiceIdle[c] = false;
+                activeVoices[activeCount++] = c;
+            }
+            return;
+        }
+
+        float attackStep = args.sampleTime / paramValue(ATTACK_PARAM);
+        float releaseStep = args.sampleTime / paramValue(RELEASE_PARAM);
+        bool velocityConnected = inputs[VELOCITY_INPUT].isConnected();
+
+        for (int g = 0; g * 4 < channels; ++g) {
+            voiceGates[g].process(inputs[GATE_INPUT].getPolyVoltageSimd<float_4>(g * 4));
+            float_4 velocity = 1.f;
+            if (velocityConnected)
+                velocity = simd::clamp(inputs[VELOCITY_INPUT].getPolyVoltageSimd<float_4>(g * 4) / 10.f, 0.f, 1.f);
+
+            // Linear attack and release towards gate * velocity
+            float_4 target = voiceGates[g].isHigh() * velocity;
+            float_4 level = voiceLevels[g];
+            level = simd::ifelse(target > level, simd::fmin(level + attackStep, target), simd::fmax(level - releaseStep, target));
+            voiceLevels[g] = level;
+
+            voiceQuietTimes[g] = simd::ifelse(level < IDLE_THRESHOLD, voiceQuietTimes[g] + args.sampleTime, 0.f);
+            int awake = simd::movemask(voiceQuietTimes[g] < IDLE_TIME);
+
+            for (int lane = 0; lane < 4 && g * 4 + lane < channels; ++lane) {
+                int c = g * 4 + lane;
+                bool idle = !(awake & (1 << lane));
+                // Silence a voice once as it goes idle, after that it costs nothing
+                if (idle && !voiceIdle[c]) {
+                    for (int id = 0; id < OUTPUTS_LEN; ++id)
+                        outputs[id].setVoltage(0.f, c);
+                }
+                voiceIdle[c] = idle;
+                if (!idle)
+                    activeVoices[activeCount++] = c;
+            }
+        }
+    }
+
+    void process(const ProcessArgs &args) override {
+        using simd::float_4;
+
+        // Per-lane waveform selection and shaper coefficients
+        // Sine, Saw, Triangle, Square
+        static const float_4 sineLane = float_4(-1.f, 0.f, 0.f, 0.f) != 0.f;
+        static const float_4 sawLane = float_4(0.f, -1.f, 0.f, 0.f) != 0.f;
+        static const float_4 triangleLane = float_4(0.f, 0.f, -1.f, 0.f) != 0.f;
+        // Square is not shaped, its shaperAmount lane is always 0
+        static const hutara::Shaper<float_4> shapers = hutara::laneShapers(
+            hutara::psychedelicShaper(), hutara::sawShaper(), hutara::psychedelicShaper(), {0.f, 0.f, 0.f});
+
+        try {
+            processModulation(args);
+
+            int channels = 1;
+            for (int id : {PITCH_INPUT_ALL, PITCH_INPUT_SINE, PITCH_INPUT_SAW, PITCH_INPUT_TRIANGLE, PITCH_INPUT_SQUARE, FM_INPUT, GATE_INPUT})
+                channels = std::max(channels, inputs[id].getChannels());
+
+            // Controls shared by every voice
+            // Read the PSYCHEDELIC_CV_KNOB_PARAM control value
+            psychedelicCVKnobValue = paramValue(PSYCHEDELIC_CV_KNOB_PARAM);
+            // Read the FM_PARAM control value
+            float fmParam = paramValue(FM_PARAM);
+            // Read the FM_AMOUNT_PARAM control value
+            float fmAmountParam = paramValue(FM_AMOUNT_PARAM);
+            float resampleParam = paramValue(RESAMPLE);
+            float sineShaperParam = paramValue(SINE_WAVESHAPER_PARAM);
+            float sawShaperParam = paramValue(SAW_WAVESHAPER_PARAM);
+            float triangleShaperParam = paramValue(PSYCHEDELIC_PARAM_TRIANGLE);
+
+            // Gather the per-oscillator controls into lanes
+            alignas(16) float pitchParams[4];
+            alignas(16) float volumeParams[4];
+            for (int i = 0; i < 4; ++i) {
+                pitchParams[i] = paramValue(PITCH_PARAM_SINE + i);
+                volumeParams[i] = paramValue(VOLUME_PARAM_SINE + i);
+            }
+            float_4 volume = float_4::load(volumeParams);
+
+            bool stereo = outputs[LEFT_OUTPUT].isConnected() || outputs[RIGHT_OUTPUT].isConnected();
+            if (stereo && panDivider.process()) {
+                alignas(16) float pan[4];
+                for (int i = 0; i < 4; ++i)
+                    pan[i] = paramValue(PAN_PARAM_SINE + i);
+                stereoBus.setPan(float_4::load(pan));
+            }
+
+            processVoiceLevels(args, channels);
+
+            float finalSum = 0.f;
+            for (int k = 0; k < activeCount; ++k) {
+                int c = activeVoices[k];
+                OscillatorBank& bank = banks[c];
+                float level = voiceLevels[c / 4][c % 4];
+
+                float pitchAll = inputs[PITCH_INPUT_ALL].getPolyVoltage(c);
+                // Modulate the PSYCHEDELIC_CV_INPUT_FOR_All using the knob value
+                float psychedelicCVAll = inputs[PSYCHEDELIC_CV_INPUT_FOR_All].getPolyVoltage(c) * psychedelicCVKnobValue;
+                // Read the FM_AMOUNT_INPUT CV value
+                float fmAmountCV = inputs[FM_AMOUNT_INPUT].getPolyVoltage(c) * fmAmountParam;
+
+                // Combine the FM_AMOUNT_PARAM and FM_AMOUNT_INPUT CV
+                float fmAmount = fmParam + fmAmountParam * fmAmountCV;
+                float fm = fmAmount * inputs[FM_INPUT].getPolyVoltage(c);
+
+                // Read the RESAMPLE_INPUT CV value
+                float resamplingFactor = inputs[RESAMPLE_INPUT].getPolyVoltage(c) * resampleParam;
+
+                alignas(16) float pitch[4];
+                for (int i = 0; i < 4; ++i)
+                    pitch[i] = pitchParams[i] + inputs[PITCH_INPUT_SINE + i].getPolyVoltage(c);
+                bank.volume = volume;
+
+                // Sine shaper is scaled by the psychedelic CV, Saw adds it and Triangle subtracts it
+                float sineShaper = sineShaperParam + psychedelicCVAll * sineShaperParam;
+                float sawShaper = sawShaperParam + inputs[PSYCHEDELIC_CV_INPUT_SAW].getPolyVoltage(c) + psychedelicCVAll;
+                float triangleShaper = triangleShaperParam + inputs[PSYCHEDELIC_CV_INPUT_TRIANGLE].getPolyVoltage(c) - psychedelicCVAll * psychedelicCVKnobValue;
+                bank.shaperAmount = float_4(sineShaper, sawShaper, triangleShaper, 0.f);
+
+                float_4 freq = dsp::FREQ_C4 * simd::pow(2.f, float_4::load(pitch) + pitchAll + fm);
+                bank.increment = freq * args.sampleTime;
+
+                // The square reads its sign before the phase advances
+                float_4 lastPhase = bank.phase;
+                bank.phase = hutara::advancePhase(bank.phase, bank.increment);
+
+                float_4 phase = bank.phase;
+                float_4 wave = simd::ifelse(sineLane, hutara::sineWave(phase),
+                               simd::ifelse(sawLane, hutara::sawWave(phase),
+                               simd::ifelse(triangleLane, hutara::triangleWave(phase), hutara::squareWave(lastPhase))));
+
+                // Psychedelic waveshaper, crossfaded by the per-lane amount
+                wave = shapers.process(wave, bank.shaperAmount);
+
+                float_4 out = 5.f * bank.volume * wave;
+                for (int i = 0; i < 4; ++i)
+                    outputs[SINE_OUTPUT + i].setVoltage(level * out[i], c);
+
+                // The resampler follows the sign of each oscillator
+                float_4 resampledValues = bank.volume * hutara::resampleSquare(hutara::squareWave(phase), float_4(resamplingFactor));
+
+                // Sum the modified outputs for the final sound
+                float finalOutput = hutara::sum(out);
+                float summedValues = hutara::sum(resampledValues);
+                float gain = level * 5.f * summedValues * resamplingFactor;
+                outputs[FINAL_OUTPUT].setVoltage(gain * finalOutput, c);
+                finalSum += gain * finalOutput;
+
+                // Same product with the oscillators panned across the stereo pair
+                if (stereo) {
+                    float left, right;
+                    stereoBus.process(out, left, right);
+                    outputs[LEFT_OUTPUT].setVoltage(gain * left, c);
+                    outputs[RIGHT_OUTPUT].setVoltage(gain * right, c);
+                }
+            }
+
+            for (int id = 0; id < OUTPUTS_LEN; ++id)
+                outputs[id].setChannels(channels);
+
+            // Peak of the output since the last light update, so short spikes still show
+            lightPeak = std::max(lightPeak, std::abs(finalSum));
+            if (lightDivider.process()) {
+                float level = clamp(lightPeak / 10.f, 0.f, 1.f);
+                lights[FINAL_OUTPUT_LIGHT].setBrightnessSmooth(level, args.sampleTime * lightDivider.getDivision());
+                lightPeak = 0.f;
+            }
+
+            if (scopeEnabled) {
+                scopeAccumulator += finalSum;
+                if (++scopeCounter >= SCOPE_DECIMATION) {
+                    scopeBuffer.push(scopeAccumulator / SCOPE_DECIMATION);
+                    scopeAccumulator = 0.f;
+                    scopeCounter = 0;
+                }
+            }
+            
+            } catch (const std::exception &e) {
+                // Handle the exception here
+                // You can log the error, display a message, or take appropriate action
+                // For now, let's print the error message to the console
+                std::cerr << "Error in FmOperator::process: " << e.what() << std::endl;
+            } catch (...) {
+                // Catch any other unexpected exceptions
+                std::cerr << "Unknown error in FmOperator::process" << std::endl;
+            }
+    }
+
+    // Initialize also clears the built-in modulation, or its offsets would keep
+    // moving the freshly reset knobs
+    void onReset() override {
+        modMatrix = ModMatrix();
+        std::fill(modOffsets, modOffsets + PARAMS_LEN, 0.f);
+        scopeEnabled = false;
+    }
+
+    json_t* dataToJson() override {
+        json_t* rootJ = json_object();
+        json_object_set_new(rootJ, "scopeEnabled", json_boolean(scopeEnabled));
+        json_object_set_new(rootJ, "modMatrix", modMatrix.toJson());
+        return rootJ;
+    }
+
+    void dataFromJson(json_t* rootJ) override {
+        json_t* scopeEnabledJ = json_object_get(rootJ, "scopeEnabled");
+        if (scopeEnabledJ)
+            scopeEnabled = json_is_true(scopeEnabledJ);
+        json_t* modMatrixJ = json_object_get(rootJ, "modMatrix");
+        if (modMatrixJ)
+            modMatrix.fromJson(modMatrixJ, PARAMS_LEN);
+    }
+};
@@ -1,306 +1,213 @@
 #include "plugin.hpp"
-#include <iostream>
-#include <cmath>
-
-struct FmOperator : Module {
-    float phaseSine = 0.f;
-    float phaseSaw = 0.f;
-    float phaseTriangle = 0.f;
-    float phaseSquare = 0.f;
-    const float fmScale = 32.23;
-    
-
-    std::vector<float> wavetable;
-    const float psychedelicCVKnobScale = 5.0f;  // Adjust the scale as needed
-    float psychedelicCVKnobValue = 0.0f;
-
-
-    enum ParamId {
-        PITCH_PARAM_SINE,
-        PITCH_PARAM_SAW,
-        PITCH_PARAM_TRIANGLE,
-        PITCH_PARAM_SQUARE,
-        FM_PARAM,
-        SINE_WAVESHAPER_PARAM, 
-        SAW_WAVESHAPER_PARAM,
-        PSYCHEDELIC_PARAM_TRIANGLE,
-        PSYCHEDELIC_CV_KNOB_PARAM,
-        FM_AMOUNT_PARAM,
-        VOLUME_PARAM_SINE,
-        VOLUME_PARAM_SAW,
-        VOLUME_PARAM_TRIANGLE,
-        VOLUME_PARAM_SQUARE,
-        RESAMPLE,
-        PARAMS_LEN
-    };
-
-    enum InputId {
-        PITCH_INPUT_SINE,
-        PITCH_INPUT_SAW,
-        PITCH_INPUT_TRIANGLE,
-        PITCH_INPUT_SQUARE,
-        FM_INPUT,
-        FM_AMOUNT_INPUT,
-        PSYCHEDELIC_CV_INPUT_SAW,
-        PSYCHEDELIC_CV_INPUT_FOR_All,
-        PSYCHEDELIC_CV_INPUT_TRIANGLE,
-        RESAMPLE_INPUT, 
-        PITCH_INPUT_ALL,
-        INPUTS_LEN
-    };
-
-    enum OutputId {
-        SINE_OUTPUT,
-        SAW_OUTPUT,
-        TRIANGLE_OUTPUT,
-        SQUARE_OUTPUT,
-        FINAL_OUTPUT,
-        OUTPUTS_LEN,
-    };
-    enum LightId {
-        FINAL_OUTPUT_LIGHT,  // Existing light ID
-        LIGHTS_LEN
-    };
-    FmOperator() {
-        config(PARAMS_LEN, INPUTS_LEN, OUTPUTS_LEN, LIGHTS_LEN);
-        configInput(PITCH_INPUT_ALL, "Pitch CV for All Osc");
-        configParam(PSYCHEDELIC_CV_KNOB_PARAM, -0.5f, 1.f, 0.f, "Psychedelic CV");
-        configParam(PITCH_PARAM_SINE, -4.f, 4.f, 0.f, "Sine Pitch");
-        configParam(PITCH_PARAM_SAW, -4.f, 4.f, 0.f, "Saw Pitch");
-        configParam(PITCH_PARAM_TRIANGLE, -4.f, 4.f, 0.f, "Triangle Pitch");
-        configParam(PITCH_PARAM_SQUARE, -4.f, 4.f, 0.f, "SQUARE Pitch");
-        configParam(FM_PARAM, -0.7, 1.23, 0.f, "FM Input");
-        configParam(SINE_WAVESHAPER_PARAM, -0.5, 1.5f, 0.f, "Sine Waveshaper");
-        configParam(SAW_WAVESHAPER_PARAM, -0.5f, 1.f, 0.f, "Saw Psychedelic");
-        configInput(PSYCHEDELIC_CV_INPUT_FOR_All, "CV_INPUT_FOR_All");
-        configParam(PSYCHEDELIC_PARAM_TRIANGLE, -0.5f, 1.f, 0.f, "Triangle Psychedelic");
-        configParam(FM_AMOUNT_PARAM, -0.5f, 0.6f, 0.f, "FM Amount");
-        configParam(VOLUME_PARAM_SINE, 0.f, 1.f, 1.f, "Sine Volume");
-        configParam(VOLUME_PARAM_SAW, 0.f, 1.f, 1.f, "Saw Volume");
-        configParam(VOLUME_PARAM_TRIANGLE, 0.f, 1.f, 1.f, "Triangle Volume");
-        configParam(VOLUME_PARAM_SQUARE, 0.f, 1.f, 1.f, "SQUARE Volume");
-        configParam(RESAMPLE, 0.0f, 0.8f, 0.8f, "Resample");
-        configInput(RESAMPLE_INPUT, "RESAMPLE Input");
-        configInput(PITCH_INPUT_SINE, "Sine Pitch CV");
-        configInput(PITCH_INPUT_SAW, "Saw Pitch CV");
-        configInput(PITCH_INPUT_TRIANGLE, "Triangle Pitch CV");
-        configInput(PITCH_INPUT_SQUARE, "SQUARE Pitch CV");
-        configInput(FM_INPUT, "FM CV");
-        configInput(FM_AMOUNT_INPUT, "FM Amount CV");
-        configInput(PSYCHEDELIC_CV_INPUT_SAW, "Saw Psychedelic CV");
-        configInput(PSYCHEDELIC_CV_INPUT_TRIANGLE, "Triangle WaveShaper CV");
-        configOutput(SINE_OUTPUT, "Sine Output");
-        configOutput(SAW_OUTPUT, "Saw Output");
-        configOutput(TRIANGLE_OUTPUT, "Triangle Output");
-        configOutput(SQUARE_OUTPUT, "SQUARE Output");
-        configOutput(FINAL_OUTPUT, "Resampling Output");
+#include "FmOperator.hpp"
+#include <cstring>
+
+// Mandala overlay that glows with FINAL_OUTPUT_LIGHT.
+// The vector art is rasterized once into the framebuffer; brightness is only
+// applied as alpha when the cached texture is composited, so a changing
+// brightness never re-rasterizes the SVG.
+struct MandalaLight : widget::FramebufferWidget {
+    FmOperator* module = nullptr;
+    widget::SvgWidget* sw;
+    float brightness = 0.f;
+
+    MandalaLight() {
+        sw = new widget::SvgWidget;
+        addChild(sw);
     }
-    
-    float triangleWaveshaper(float x) {
-        return 2.0f * std::abs(2.0f * (x - 0.25f) - 1.0f) - 1.0f;
+
+    void setSvg(std::shared_ptr<window::Svg> svg) {
+        sw->setSvg(svg);
+        box.size = sw->box.size;
+        setDirty();
     }
 
-    float sineWaveshaper(float x) {
-        return 2.0f * std::abs(2.0f * (x - 0.25f) - 1.0f) - 1.0f;
+    void step() override {
+        // Show the art at full brightness in the module browser
+        brightness = module ? module->lights[FmOperator::FINAL_OUTPUT_LIGHT].getBrightness() : 1.f;
+        FramebufferWidget::step();
     }
 
-    float sawWaveshaper(float x) {
-        return 0.8f * (std::sin(4.f * M_PI * x) + std::cos(6.f * M_PI * x));
+    void draw(const DrawArgs& args) override {
+        // Drawn on the light layer only, so it glows when the room is dimmed
     }
-    float frequencyWaveshaper(float x) {
-        if (wavetable.size() > 0) {
-            float index = (x + 1.0f) * 0.5f * (wavetable.size() - 1);
-            int i0 = static_cast<int>(std::floor(index));
-            int i1 = static_cast<int>(std::ceil(index));
-            float frac = index - i0;
-
-            float y0 = triangleWaveshaper(wavetable[i0]); // You can replace this with sineWaveshaper to use the sine waveshaper
-            float y1 = triangleWaveshaper(wavetable[i1]); // Replace with sineWaveshaper
-
-            return y0 + frac * (y1 - y0);
-        } else {
-            return x;
+
+    void drawLayer(const DrawArgs& args, int layer) override {
+        if (layer == 1 && brightness > 0.f) {
+            nvgSave(args.vg);
+            nvgGlobalAlpha(args.vg, brightness);
+            FramebufferWidget::draw(args);
+            nvgRestore(args.vg);
         }
+        FramebufferWidget::drawLayer(args, layer);
     }
+};
 
-
-
-    float sinc(float x) {
-        if (x == 0.0f) return 1.0f;
-        return sin(M_PI * x) / (M_PI * x);
+// Waveform and spectrum of FINAL_OUTPUT, read from the module's scope buffer at frame rate
+struct ScopeDisplay : LedDisplay {
+    static const int HISTORY = 512;
+
+    FmOperator* module = nullptr;
+    // Most recent samples, oldest first
+    float history[HISTORY] = {};
+    alignas(16) float fftInput[HISTORY];
+    alignas(16) float fftOutput[HISTORY];
+    float window[HISTORY];
+    // Magnitude in dB for each bin up to Nyquist
+    float spectrum[HISTORY / 2] = {};
+    dsp::RealFFT fft{HISTORY};
+
+    ScopeDisplay() {
+        for (int i = 0; i < HISTORY; ++i)
+            window[i] = 0.5f - 0.5f * std::cos(2.f * M_PI * i / (HISTORY - 1));
     }
 
+    bool isEnabled() {
+        return module && module->scopeEnabled;
+    }
 
-    float resampled(float x, float cvInput) {
-        // Resample the square wave based on the cvInput
-        const int numSamples = 8; // Adjust this based 
-        float waveSamples[numSamples];
-        for (int i = 0; i < numSamples; ++i) {
-            waveSamples[i] = (i % 2 == 0) ? 1.0f : -1.0f;
+    void step() override {
+        LedDisplay::step();
+        if (!module)
+            return;
+
+        // Drain everything so the buffer never fills up, keeping the newest HISTORY samples
+        float chunk[256];
+        int received = 0;
+        size_t n;
+        while ((n = module->scopeBuffer.pop(chunk, 256)) > 0) {
+            int count = static_cast<int>(n);
+            int keep = std::min(count, HISTORY);
+            std::memmove(history, history + keep, (HISTORY - keep) * sizeof(float));
+            std::memcpy(history + HISTORY - keep, chunk + count - keep, keep * sizeof(float));
+            received += count;
+        }
+        if (received == 0)
+            return;
+
+        for (int i = 0; i < HISTORY; ++i)
+            fftInput[i] = history[i] * window[i];
+        fft.rfft(fftInput, fftOutput);
+        // Packed output, bin 0 holds DC and Nyquist
+        for (int k = 1; k < HISTORY / 2; ++k) {
+            float re = fftOutput[2 * k];
+            float im = fftOutput[2 * k + 1];
+            spectrum[k] = 10.f * std::log10(re * re + im * im + 1e-12f);
         }
+    }
+
+    void draw(const DrawArgs& args) override {
+        if (isEnabled())
+            LedDisplay::draw(args);
+    }
 
-        // Adjust the resampling rate based on the cvInput
-        float resamplingRate = 0.5f + cvInput; // You may need to adjust this scaling
-        float index = (x + 1.0f) * 0.5f * (numSamples - 1) * resamplingRate;
-        int i0 = static_cast<int>(std::floor(index));
-        float frac = index - i0;
-
-        // Apply windowed sinc interpolation for better results
-        float interpolatedValue = 0.4f;
-        for (int i = -4; i <= 4; ++i) {
-            int idx = i0 + i;
-            if (idx >= 0 && idx < numSamples) {
-                float window = 0.54 - 0.46 * cos(2.0 * M_PI * i / 8.0);
-                float weight = sinc(i - frac) * window;
-                interpolatedValue += weight * waveSamples[idx];
+    void drawLayer(const DrawArgs& args, int layer) override {
+        if (layer == 1 && isEnabled()) {
+            float w = box.size.x;
+            float h = box.size.y / 2.f;
+
+            // Waveform on top, scaled to its own peak so any level is readable
+            float peak = 1.f;
+            for (float v : history)
+                peak = std::max(peak, std::abs(v));
+            nvgBeginPath(args.vg);
+            for (int i = 0; i < HISTORY; ++i) {
+                float x = w * i / (HISTORY - 1);
+                float y = h * (0.5f - 0.45f * history[i] / peak);
+                if (i == 0)
+                    nvgMoveTo(args.vg, x, y);
+                else
+                    nvgLineTo(args.vg, x, y);
+            }
+            nvgStrokeColor(args.vg, nvgRGB(0xff, 0x40, 0xc0));
+            nvgStrokeWidth(args.vg, 1.f);
+            nvgStroke(args.vg);
+
+            // Spectrum below on a log frequency axis, 60 dB range under the loudest bin
+            float maxDb = -120.f;
+            for (int k = 1; k < HISTORY / 2; ++k)
+                maxDb = std::max(maxDb, spectrum[k]);
+            nvgBeginPath(args.vg);
+            for (int k = 1; k < HISTORY / 2; ++k) {
+                float x = w * std::log((float) k) / std::log(HISTORY / 2.f - 1.f);
+                float level = clamp((spectrum[k] - maxDb + 60.f) / 60.f, 0.f, 1.f);
+                float y = h + h * (1.f - level);
+                if (k == 1)
+                    nvgMoveTo(args.vg, x, y);
+                else
+                    nvgLineTo(args.vg, x, y);
             }
+            nvgStrokeColor(args.vg, nvgRGB(0x40, 0xe0, 0xff));
+            nvgStroke(args.vg);
         }
+        LedDisplay::drawLayer(args, layer);
+    }
+};
+
+// Context menu slider bound to one float setting of the modulation matrix
+struct ModQuantity : Quantity {
+    float* value;
+    std::string label;
+    std::string unit;
+    float minValue;
+    float maxValue;
+    float defaultValue;
 
-        // Adjust the amplitude of the resampled square wave
-        return interpolatedValue; // Adjust the constant factor as needed
+    ModQuantity(float* value, std::string label, std::string unit, float minValue, float maxValue, float defaultValue)
+        : value(value), label(label), unit(unit), minValue(minValue), maxValue(maxValue), defaultValue(defaultValue) {}
+
+    void setValue(float value) override {
+        *this->value = clamp(value, minValue, maxValue);
     }
-    void process(const ProcessArgs &args) override {
-        try {
-            float pitchAll = inputs[PITCH_INPUT_ALL].getVoltage();
-            // Read the PSYCHEDELIC_CV_KNOB_PARAM control value
-            psychedelicCVKnobValue = params[PSYCHEDELIC_CV_KNOB_PARAM].getValue();
-
-            // Modulate the PSYCHEDELIC_CV_INPUT_FOR_All using the knob value
-            float psychedelicCVAll = inputs[PSYCHEDELIC_CV_INPUT_FOR_All].getVoltage() * params[PSYCHEDELIC_CV_KNOB_PARAM].getValue();
-            // Modulate the PSYCHEDELIC_CV_INPUT_FOR_All using the knob value
-            float invertpsychedelicCVAll = -psychedelicCVAll;
-            psychedelicCVAll += psychedelicCVKnobValue * psychedelicCVKnobScale;    
-            // Read the FM_PARAM control value
-            float fmAmount = params[FM_PARAM].getValue();
-            // Read the FM_AMOUNT_PARAM control value
-            float fmAmountParam = params[FM_AMOUNT_PARAM].getValue();
-            // Read the FM_AMOUNT_INPUT CV value
-            float fmAmountCV = inputs[FM_AMOUNT_INPUT].getVoltage() * params[FM_AMOUNT_PARAM].getValue();
-
-            // Combine the FM_AMOUNT_PARAM and FM_AMOUNT_INPUT CV
-            fmAmount += fmAmountParam * fmAmountCV;
-            // Read the SINE_WAVESHAPER_PARAM control value
-            float sineWaveshaperAmount = params[SINE_WAVESHAPER_PARAM].getValue();
-            // Read the SINE_WAVESHAPER_CV_INPUT CV value
-            float sineWaveshaperCV = inputs[PSYCHEDELIC_CV_INPUT_FOR_All].getVoltage() * params[SINE_WAVESHAPER_PARAM].getValue() * params[PSYCHEDELIC_CV_KNOB_PARAM].getValue();
-
-            // Combine the SINE_WAVESHAPER_PARAM and PSYCHEDELIC_CV_INPUT_FOR_All CV
-            sineWaveshaperAmount += sineWaveshaperCV;
-
-            float threshold = 0.5f;
-            // Read the RESAMPLE_INPUT CV value
-            float resamplingFactor = inputs[RESAMPLE_INPUT].getVoltage() * params[RESAMPLE].getValue();
-            // Read the RESAMPLE_INPUT CV value
-
-            
-            // Triangle Oscillator
-            float pitchTriangle = params[PITCH_PARAM_TRIANGLE].getValue() + inputs[PITCH_INPUT_TRIANGLE].getVoltage() + pitchAll;
-            float volumeTriangle = params[VOLUME_PARAM_TRIANGLE].getValue();
-            float freqTriangle = dsp::FREQ_C4 * std::pow(2.f, pitchTriangle + fmAmount * inputs[FM_INPUT].getVoltage());
-
-            float psychedelicCVTriangle = inputs[PSYCHEDELIC_CV_INPUT_TRIANGLE].getVoltage() + invertpsychedelicCVAll * params[PSYCHEDELIC_CV_KNOB_PARAM].getValue();
-            float psychedelicParamTriangle = params[PSYCHEDELIC_PARAM_TRIANGLE].getValue() + psychedelicCVTriangle;
-
-            phaseTriangle += freqTriangle * args.sampleTime;
-            if (phaseTriangle >= 1.f)
-                phaseTriangle -= 1.f;
-            float resampledTriangleValue = resampled((phaseTriangle < threshold) ? -1.0f : 1.0f, resamplingFactor);
-
-            float triangle = 2.f * (std::abs(2.f * phaseTriangle - 1.f) - 0.5f);
-            triangle = (psychedelicParamTriangle == 0.0) ? triangle : (1.0 - psychedelicParamTriangle) * triangle + psychedelicParamTriangle * 0.5f * (std::sin(3.f * M_PI * triangle) + std::cos(5.f * M_PI * triangle));
-            outputs[TRIANGLE_OUTPUT].setVoltage(5.f * volumeTriangle * triangle);
-
-            // Sine Oscillator
-            float pitchSine = params[PITCH_PARAM_SINE].getValue() + inputs[PITCH_INPUT_SINE].getVoltage() + pitchAll;
-            float volumeSine = params[VOLUME_PARAM_SINE].getValue();
-            float freqSine = dsp::FREQ_C4 * std::pow(2.f, pitchSine + fmAmount * inputs[FM_INPUT].getVoltage());
-
-            phaseSine += freqSine * args.sampleTime;
-            if (phaseSine >= 1.f)
-                phaseSine -= 1.f;
-
-            float resampledSineValue = resampled((phaseSine < threshold) ? -1.0f : 1.0f, resamplingFactor);
-
-            float sine = std::sin(2.f * M_PI * phaseSine);
-            // Apply the sineWaveshaper effect to the Sine oscillator using SINE_WAVESHAPER_PARAM
-            sine = (sineWaveshaperAmount == 0.0) ? sine : (1.0 - sineWaveshaperAmount) * sine + sineWaveshaperAmount * 0.5f * (std::sin(3.f * M_PI * sine) + std::cos(5.f * M_PI * sine));
-            outputs[SINE_OUTPUT].setVoltage(5.f * volumeSine * sine);
-
-            // Saw Oscillator
-            float pitchSaw = params[PITCH_PARAM_SAW].getValue() + inputs[PITCH_INPUT_SAW].getVoltage() + pitchAll;
-            float volumeSaw = params[VOLUME_PARAM_SAW].getValue();
-            float freqSaw = dsp::FREQ_C4 * std::pow(2.f, pitchSaw + fmAmount * inputs[FM_INPUT].getVoltage());
-            phaseSaw += freqSaw * args.sampleTime;
-            if (phaseSaw >= 1.f)
-                phaseSaw -= 1.f;
-
-            // Use the existing variable for the resampling factor
-            float resampledSawValue = resampled((phaseSaw < threshold) ? -1.0f : 1.0f, resamplingFactor);
-            
-            float psychedelicCVsaw = inputs[PSYCHEDELIC_CV_INPUT_SAW].getVoltage() + inputs[PSYCHEDELIC_CV_INPUT_FOR_All].getVoltage() * params[PSYCHEDELIC_CV_KNOB_PARAM].getValue();
-            float sawWaveshaperAmount = params[SAW_WAVESHAPER_PARAM].getValue() + psychedelicCVsaw;
-
-            float sawValue = 2.f * (phaseSaw - std::floor(phaseSaw));
-            // Apply the sawWaveshaper effect to the Saw oscillator using SAW_WAVESHAPER_PARAM
-            sawValue = (sawWaveshaperAmount == 0.0) ? sawValue : (1.0 - sawWaveshaperAmount) * sawValue + sawWaveshaperAmount * 0.5f * sawWaveshaper(sawValue);
-            outputs[SAW_OUTPUT].setVoltage(5.f * volumeSaw * sawValue );
-
-            // Square Oscillator with Resampling
-            float pitchSquare = params[PITCH_PARAM_SQUARE].getValue() + inputs[PITCH_INPUT_SQUARE].getVoltage() + pitchAll;
-            float volumeSquare = params[VOLUME_PARAM_SQUARE].getValue();
-            float freqSquare = dsp::FREQ_C4 * std::pow(2.f, pitchSquare + fmAmount * inputs[FM_INPUT].getVoltage());
-
-            // Use a boolean to determine the sign of the square wave
-            bool isNegative = (phaseSquare < 0.5f);
-
-            // Update the phaseSquare with the frequency
-            phaseSquare += freqSquare * args.sampleTime;
-            if (phaseSquare >= 1.f)
-            phaseSquare -= 1.f;
-
-            // Set the square wave value based on the boolean
-            float square = isNegative ? -1.0f : 1.0f;
-            float resampledSquareValue = resampled((phaseSquare < threshold) ? -1.0f : 1.0f, resamplingFactor);
-            // Adjust the amplitude of the square wave
-            outputs[SQUARE_OUTPUT].setVoltage(5.f * volumeSquare * square);
-
-            resampledSawValue *= volumeSaw;
-            resampledSineValue *= volumeSine;
-            resampledSquareValue *= volumeSquare;
-            resampledTriangleValue *= volumeTriangle;
-
-            // Sum the modified outputs for the final sound
-            float finalOutput = outputs[TRIANGLE_OUTPUT].getVoltage() +
-                                outputs[SINE_OUTPUT].getVoltage() +
-                                outputs[SAW_OUTPUT].getVoltage() +
-                                outputs[SQUARE_OUTPUT].getVoltage();
-                               
-            float summedValues = + resampledTriangleValue + resampledSineValue + resampledSawValue + resampledSquareValue ;
-            outputs[FINAL_OUTPUT].setVoltage((5.0 * finalOutput * summedValues * resamplingFactor));     
-            
-            } catch (const std::exception &e) {
-                // Handle the exception here
-                // You can log the error, display a message, or take appropriate action
-                // For now, let's print the error message to the console
-                std::cerr << "Error in FmOperator::process: " << e.what() << std::endl;
-            } catch (...) {
-                // Catch any other unexpected exceptions
-                std::cerr << "Unknown error in FmOperator::process" << std::endl;
-            }
+    float getValue() override {
+        return *value;
+    }
+    float getMinValue() override {
+        return minValue;
+    }
+    float getMaxValue() override {
+        return maxValue;
+    }
+    float getDefaultValue() override {
+        return defaultValue;
+    }
+    std::string getLabel() override {
+        return label;
+    }
+    std::string getUnit() override {
+        return unit;
+    }
+};
+
+struct ModSlider : ui::Slider {
+    ModSlider(ModQuantity* quantity) {
+        this->quantity = quantity;
+        box.size.x = 200.f;
+    }
+    ~ModSlider() {
+        delete quantity;
     }
 };
 
 struct FmOperatorWidget : ModuleWidget {
     FmOperatorWidget(FmOperator* module) {
         setModule(module);
+        // SvgPanel keeps the panel art in its own FramebufferWidget, so it is
+        // only rasterized again on zoom changes
         setPanel(createPanel(asset::plugin(pluginInstance, "res/HutaraFm.svg")));    
 
-        SvgLight* svgLight = createWidget<SvgLight>(mm2px(Vec(60, 50)));  // Adjust the position as needed
+        MandalaLight* mandalaLight = createWidget<MandalaLight>(mm2px(Vec(60, 50)));  // Adjust the position as needed
+        mandalaLight->module = module;
 
         // Load the SVG file for the light
         std::string svgPathLight = asset::plugin(pluginInstance, "res/mandala.svg");
-        svgLight->setSvg(APP->window->loadSvg(svgPathLight));
-        addChild(svgLight);
+        mandalaLight->setSvg(APP->window->loadSvg(svgPathLight));
+        addChild(mandalaLight);
+
+        ScopeDisplay* scopeDisplay = createWidget<ScopeDisplay>(mm2px(Vec(31, 47)));
+        scopeDisplay->box.size = mm2px(Vec(25, 36));
+        scopeDisplay->module = module;
+        addChild(scopeDisplay);
 
         addChild(createWidget<ScrewSilver>(Vec(RACK_GRID_WIDTH, 0)));
         addChild(createWidget<ScrewSilver>(Vec(box.size.x - 2 * RACK_GRID_WIDTH, 0)));
@@ -321,8 +228,17 @@ struct FmOperatorWidget : ModuleWidget {
         addParam(createParamCentered<Rogan1PRed>(mm2px(Vec(65, 77.063)), module, FmOperator::RESAMPLE));
         addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(22.24, 108.400)), module, FmOperator::VOLUME_PARAM_TRIANGLE));
         addParam(createParamCentered<RoundBlackKnob>(mm2px(Vec(61.24, 108.400)), module, FmOperator::VOLUME_PARAM_SQUARE)); 
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(8, 76)), module, FmOperator::PAN_PARAM_SINE));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(8, 84)), module, FmOperator::PAN_PARAM_SAW));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(8, 92)), module, FmOperator::PAN_PARAM_TRIANGLE));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(8, 100)), module, FmOperator::PAN_PARAM_SQUARE));
         
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(20.24, 10.0)), module, FmOperator::PITCH_INPUT_ALL));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(8, 110)), module, FmOperator::MOD_TRIGGER_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(37, 13.5)), module, FmOperator::GATE_INPUT));
+        addInput(createInputCentered<PJ301MPort>(mm2px(Vec(47, 13.5)), module, FmOperator::VELOCITY_INPUT));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(37, 22.5)), module, FmOperator::ATTACK_PARAM));
+        addParam(createParamCentered<Trimpot>(mm2px(Vec(47, 22.5)), module, FmOperator::RELEASE_PARAM));
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(77, 71)), module, FmOperator::RESAMPLE_INPUT));  // Adjust position
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(25.24, 25.0)), module, FmOperator::PITCH_INPUT_TRIANGLE));
         addInput(createInputCentered<PJ301MPort>(mm2px(Vec(18.24, 51.0)), module, FmOperator::PITCH_INPUT_SAW));
@@ -338,6 +254,74 @@ struct FmOperatorWidget : ModuleWidget {
         addOutput(createOutputCentered<DarkPJ301MPort>(mm2px(Vec(22.24, 118.713)), module, FmOperator::TRIANGLE_OUTPUT));
         addOutput(createOutputCentered<DarkPJ301MPort>(mm2px(Vec(61.24, 118.713)), module, FmOperator::SQUARE_OUTPUT));
         addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(77.24, 83)), module, FmOperator::FINAL_OUTPUT));
+        addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(77.24, 98.4)), module, FmOperator::LEFT_OUTPUT));
+        addOutput(createOutputCentered<PJ3410Port>(mm2px(Vec(77.24, 113)), module, FmOperator::RIGHT_OUTPUT));
+    }
+
+    void appendContextMenu(Menu* menu) override {
+        FmOperator* module = dynamic_cast<FmOperator*>(this->module);
+        if (!module)
+            return;
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createBoolPtrMenuItem("Show scope", "", &module->scopeEnabled));
+        menu->addChild(createSubmenuItem("Modulation", "", [=](Menu* menu) {
+            appendModulationMenu(menu, module);
+        }));
+    }
+
+    static void appendModulationMenu(Menu* menu, FmOperator* module) {
+        ModMatrix* modMatrix = &module->modMatrix;
+        std::vector<std::string> sourceLabels = {"LFO 1", "LFO 2", "LFO 3", "Envelope 1", "Envelope 2"};
+        std::vector<std::string> paramLabels;
+        for (int id = 0; id < FmOperator::PARAMS_LEN; ++id)
+            paramLabels.push_back(module->paramQuantities[id]->getLabel());
+
+        for (int i = 0; i < ModMatrix::NUM_LFOS; ++i) {
+            menu->addChild(createSubmenuItem(sourceLabels[ModMatrix::LFO_1 + i], "", [=](Menu* menu) {
+                ModMatrix::Lfo* lfo = &modMatrix->lfos[i];
+                menu->addChild(new ModSlider(new ModQuantity(&lfo->rate, "Rate", " Hz", ModMatrix::MIN_RATE, ModMatrix::MAX_RATE, 1.f)));
+                menu->addChild(createIndexSubmenuItem("Shape", {"Sine", "Triangle", "Saw", "Square", "Random"},
+                    [=]() {return lfo->shape;},
+                    [=](int shape) {lfo->shape = shape;}
+                ));
+            }));
+        }
+        for (int i = 0; i < ModMatrix::NUM_ENVS; ++i) {
+            menu->addChild(createSubmenuItem(sourceLabels[ModMatrix::ENV_1 + i], "", [=](Menu* menu) {
+                ModMatrix::Envelope* env = &modMatrix->envs[i];
+                menu->addChild(createMenuLabel("Triggered by the Mod Trigger input"));
+                menu->addChild(new ModSlider(new ModQuantity(&env->attack, "Attack", " s", ModMatrix::MIN_TIME, ModMatrix::MAX_TIME, 0.01f)));
+                menu->addChild(new ModSlider(new ModQuantity(&env->decay, "Decay", " s", ModMatrix::MIN_TIME, ModMatrix::MAX_TIME, 0.5f)));
+            }));
+        }
+
+        menu->addChild(new MenuSeparator);
+        menu->addChild(createMenuLabel("Routes"));
+        for (int r = 0; r < ModMatrix::MAX_ROUTES; ++r) {
+            ModMatrix::Route* route = &modMatrix->routes[r];
+            if (route->source < 0)
+                continue;
+            std::string text = sourceLabels[route->source] + " > " + paramLabels[route->paramId];
+            menu->addChild(createSubmenuItem(text, string::f("%+.0f%%", route->depth * 100.f), [=](Menu* menu) {
+                menu->addChild(createIndexSubmenuItem("Source", sourceLabels,
+                    [=]() {return route->source;},
+                    [=](int source) {route->source = source;}
+                ));
+                menu->addChild(createIndexSubmenuItem("Destination", paramLabels,
+                    [=]() {return route->paramId;},
+                    [=](int paramId) {route->paramId = paramId;}
+                ));
+                menu->addChild(new ModSlider(new ModQuantity(&route->depth, "Depth", "", -1.f, 1.f, 0.f)));
+                menu->addChild(createMenuItem("Remove", "", [=]() {
+                    modMatrix->removeRoute(r);
+                }));
+            }));
+        }
+        bool full = modMatrix->getRouteCount() >= ModMatrix::MAX_ROUTES;
+        menu->addChild(createMenuItem("Add route", "", [=]() {
+            modMatrix->addRoute(ModMatrix::LFO_1, FmOperator::FM_PARAM, 0.25f);
+        }, full));
     }
 
 };
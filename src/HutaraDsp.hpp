@@ -0,0 +1,242 @@
+#pragma once
+#include <rack.hpp>
+#include <cmath>
+#include <cstdint>
+
+// Header-only DSP core shared by the Hutara modules.
+// Every kernel is templated on the sample type T, either float or simd::float_4,
+// so the scalar and SIMD paths run the same code.
+namespace hutara {
+
+using rack::simd::float_4;
+
+// Lane access so templated code can treat float as a one-lane vector
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<float> {
+    static const int size = 1;
+    static float& get(float& x, int i) {
+        return x;
+    }
+};
+
+template <>
+struct Lanes<float_4> {
+    static const int size = 4;
+    static float& get(float_4& x, int i) {
+        return x[i];
+    }
+};
+
+
+// Oscillators, phase in [0, 1)
+
+// Advances the phase by one sample and wraps it back into [0, 1)
+template <typename T>
+T advancePhase(T phase, T increment) {
+    phase += increment;
+    return phase - rack::simd::ifelse(phase >= 1.f, T(1.f), T(0.f));
+}
+
+template <typename T>
+T sineWave(T phase) {
+    return rack::simd::sin(2.f * float(M_PI) * phase);
+}
+
+// Rising ramp from 0 to 2, as the module has always output it
+template <typename T>
+T sawWave(T phase) {
+    return 2.f * (phase - rack::simd::floor(phase));
+}
+
+template <typename T>
+T triangleWave(T phase) {
+    return 2.f * (rack::simd::fabs(2.f * phase - 1.f) - 0.5f);
+}
+
+template <typename T>
+T squareWave(T phase) {
+    return rack::simd::ifelse(phase < 0.5f, T(-1.f), T(1.f));
+}
+
+
+// Shapers
+
+// Crossfades x towards gain * (sin(sinFreq * x) + cos(cosFreq * x)) by amount.
+// amount 0 leaves x untouched.
+template <typename T>
+T waveshape(T x, T amount, T gain, T sinFreq, T cosFreq) {
+    T shaped = gain * (rack::simd::sin(sinFreq * x) + rack::simd::cos(cosFreq * x));
+    return x + amount * (shaped - x);
+}
+
+// Coefficients of one waveshape() curve, per lane when T is float_4
+template <typename T>
+struct Shaper {
+    T gain;
+    T sinFreq;
+    T cosFreq;
+
+    T process(T x, T amount) const {
+        return waveshape<T>(x, amount, gain, sinFreq, cosFreq);
+    }
+};
+
+// Sine and Triangle psychedelic shaper
+inline Shaper<float> psychedelicShaper() {
+    return {0.5f, 3.f * float(M_PI), 5.f * float(M_PI)};
+}
+
+// Saw psychedelic shaper, half of 0.8 * (sin(4 pi x) + cos(6 pi x))
+inline Shaper<float> sawShaper() {
+    return {0.4f, 4.f * float(M_PI), 6.f * float(M_PI)};
+}
+
+// Packs four scalar shapers into one, lane i runs shaper i
+inline Shaper<float_4> laneShapers(const Shaper<float>& s0, const Shaper<float>& s1, const Shaper<float>& s2, const Shaper<float>& s3) {
+    return {
+        float_4(s0.gain, s1.gain, s2.gain, s3.gain),
+        float_4(s0.sinFreq, s1.sinFreq, s2.sinFreq, s3.sinFreq),
+        float_4(s0.cosFreq, s1.cosFreq, s2.cosFreq, s3.cosFreq),
+    };
+}
+
+
+// Sinc and resampling kernels
+
+template <typename T>
+T sinc(T x) {
+    T px = float(M_PI) * x;
+    auto isZero = (x == 0.f);
+    // Keep the division finite in the lanes that take the 1 branch
+    return rack::simd::ifelse(isZero, T(1.f), rack::simd::sin(px) / rack::simd::ifelse(isZero, T(1.f), px));
+}
+
+// Reads a +1/-1 alternating 8-sample table at the position of x in [-1, 1],
+// stretched by 0.5 + cvInput, through a 9-tap Hamming-windowed sinc.
+template <typename T>
+T resampleSquare(T x, T cvInput) {
+    const int numSamples = 8;
+    T resamplingRate = 0.5f + cvInput;
+    T index = (x + 1.f) * 0.5f * (numSamples - 1) * resamplingRate;
+    T i0 = rack::simd::floor(index);
+    T frac = index - i0;
+
+    T interpolatedValue = 0.4f;
+    for (int i = -4; i <= 4; ++i) {
+        T idx = i0 + float(i);
+        // Table is +1 at even and -1 at odd indices
+        T half = 0.5f * idx;
+        T sample = rack::simd::ifelse(half == rack::simd::floor(half), T(1.f), T(-1.f));
+        auto inTable = (idx >= 0.f) & (idx < float(numSamples));
+        float window = 0.54f - 0.46f * std::cos(2.f * float(M_PI) * i / 8.f);
+        T weight = sinc(float(i) - frac) * window;
+        interpolatedValue += rack::simd::ifelse(inTable, weight * sample, T(0.f));
+    }
+    return interpolatedValue;
+}
+
+
+// Mixing
+
+inline float sum(float_4 x) {
+    return x[0] + x[1] + x[2] + x[3];
+}
+
+// Mixes four mono inputs down to a stereo pair with one pan position per input.
+// The gains change only in setPan(), so the pan law can run at control rate.
+struct StereoBus {
+    float_4 gainLeft = float(M_SQRT1_2);
+    float_4 gainRight = float(M_SQRT1_2);
+
+    // pan in [-1, 1], constant-power law, -3 dB in each side at the centre
+    void setPan(float_4 pan) {
+        float_4 angle = (rack::simd::clamp(pan, -1.f, 1.f) + 1.f) * float(M_PI / 4);
+        gainLeft = rack::simd::cos(angle);
+        gainRight = rack::simd::sin(angle);
+    }
+
+    void process(float_4 in, float& left, float& right) {
+        left = sum(in * gainLeft);
+        right = sum(in * gainRight);
+    }
+};
+
+
+// Random numbers
+
+// xoroshiro128+, fast and good enough for modulation sources
+struct Prng {
+    uint64_t state[2] = {0x9e3779b97f4a7c15ull, 0xbf58476d1ce4e5b9ull};
+
+    void seed(uint64_t s0, uint64_t s1) {
+        state[0] = s0;
+        state[1] = s1;
+        // The all-zero state never leaves zero
+        if (state[0] == 0 && state[1] == 0)
+            state[0] = 1;
+        // Warm up past correlated first outputs of similar seeds
+        for (int i = 0; i < 16; ++i)
+            next();
+    }
+
+    uint64_t next() {
+        uint64_t s0 = state[0];
+        uint64_t s1 = state[1];
+        uint64_t result = s0 + s1;
+        s1 ^= s0;
+        state[0] = rotl(s0, 55) ^ s1 ^ (s1 << 14);
+        state[1] = rotl(s1, 36);
+        return result;
+    }
+
+    // Uniform in [0, 1) in every lane
+    template <typename T>
+    T uniform() {
+        T x;
+        for (int i = 0; i < Lanes<T>::size; ++i)
+            Lanes<T>::get(x, i) = (next() >> 40) * (1.f / (1u << 24));
+        return x;
+    }
+
+    // Uniform in [-1, 1) in every lane
+    template <typename T>
+    T bipolar() {
+        return 2.f * uniform<T>() - 1.f;
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+};
+
+
+// Edge detection
+
+// Goes high when the input reaches highThreshold and low again once it drops
+// below lowThreshold. process() returns 1 in each lane that just went high, else 0.
+template <typename T>
+struct EdgeDetector {
+    // 1 while high, 0 while low
+    T state = 0.f;
+
+    void reset() {
+        state = 0.f;
+    }
+
+    T process(T in, float lowThreshold = 0.1f, float highThreshold = 1.f) {
+        T high = rack::simd::ifelse(in >= highThreshold, T(1.f), rack::simd::ifelse(in < lowThreshold, T(0.f), state));
+        T rising = rack::simd::ifelse(high > state, T(1.f), T(0.f));
+        state = high;
+        return rising;
+    }
+
+    T isHigh() {
+        return state;
+    }
+};
+
+} // namespace hutara
@@ -0,0 +1,233 @@
+#pragma once
+#include "HutaraDsp.hpp"
+#include <algorithm>
+
+// Built-in modulation for FmOperator: a few LFOs and AD envelopes routed to
+// params through a short list of routes. Runs at control rate, and only the
+// sources that an active route reads are advanced.
+struct ModMatrix {
+    enum SourceId {
+        LFO_1,
+        LFO_2,
+        LFO_3,
+        ENV_1,
+        ENV_2,
+        SOURCES_LEN
+    };
+    static const int NUM_LFOS = 3;
+    static const int NUM_ENVS = 2;
+    static const int MAX_ROUTES = 8;
+
+    // Ranges of the context menu sliders, also enforced on patch load
+    static constexpr float MIN_RATE = 0.01f;
+    static constexpr float MAX_RATE = 20.f;
+    static constexpr float MIN_TIME = 0.001f;
+    static constexpr float MAX_TIME = 10.f;
+
+    enum LfoShape {
+        LFO_SINE,
+        LFO_TRIANGLE,
+        LFO_SAW,
+        LFO_SQUARE,
+        LFO_RANDOM,
+        LFO_SHAPES_LEN
+    };
+
+    struct Lfo {
+        float rate = 1.f;  // Hz
+        int shape = LFO_SINE;
+        float phase = 0.f;
+        float held = 0.f;
+
+        // Bipolar output in [-1, 1]
+        float process(float deltaTime, hutara::Prng& prng) {
+            float lastPhase = phase;
+            phase = hutara::advancePhase(phase, rate * deltaTime);
+            switch (shape) {
+                case LFO_TRIANGLE: return hutara::triangleWave(phase);
+                case LFO_SAW: return hutara::sawWave(phase) - 1.f;
+                case LFO_SQUARE: return hutara::squareWave(phase);
+                case LFO_RANDOM:
+                    // New random step each cycle
+                    if (phase < lastPhase)
+                        held = prng.bipolar<float>();
+                    return held;
+                default: return hutara::sineWave(phase);
+            }
+        }
+    };
+
+    // Linear attack/decay envelope, restarted by trigger()
+    struct Envelope {
+        float attack = 0.01f;  // seconds
+        float decay = 0.5f;  // seconds
+        float value = 0.f;
+        bool attacking = false;
+
+        void trigger() {
+            attacking = true;
+        }
+
+        // Unipolar output in [0, 1]
+        float process(float deltaTime) {
+            if (attacking) {
+                value += deltaTime / std::max(attack, 1e-3f);
+                if (value >= 1.f) {
+                    value = 1.f;
+                    attacking = false;
+                }
+            } else {
+                value = std::max(value - deltaTime / std::max(decay, 1e-3f), 0.f);
+            }
+            return value;
+        }
+    };
+
+    struct Route {
+        // -1 while the slot is unused
+        int source = -1;
+        int paramId = 0;
+        // Fraction of the destination param's range at full source level
+        float depth = 0.f;
+    };
+
+    Lfo lfos[NUM_LFOS];
+    Envelope envs[NUM_ENVS];
+    Route routes[MAX_ROUTES];
+    hutara::Prng prng;
+    bool triggerPending = false;
+
+    // Envelopes restart on the next process()
+    void trigger() {
+        triggerPending = true;
+    }
+
+    // Returns the slot of the new route, or -1 when all slots are in use
+    int addRoute(int source, int paramId, float depth) {
+        for (int i = 0; i < MAX_ROUTES; ++i) {
+            if (routes[i].source < 0) {
+                routes[i].paramId = paramId;
+                routes[i].depth = depth;
+                routes[i].source = source;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void removeRoute(int i) {
+        routes[i].source = -1;
+    }
+
+    int getRouteCount() {
+        int count = 0;
+        for (const Route& route : routes)
+            count += (route.source >= 0);
+        return count;
+    }
+
+    // Advances the routed sources by deltaTime and adds each active route's
+    // modulation to amounts[paramId], in fractions of the param range
+    void process(float deltaTime, float* amounts) {
+        // The context menu edits routes from the UI thread, so copy each one
+        // once and only read the copies below
+        Route active[MAX_ROUTES];
+        int activeCount = 0;
+        bool used[SOURCES_LEN] = {};
+        for (const Route& route : routes) {
+            Route copy = route;
+            if (copy.source >= 0 && copy.source < SOURCES_LEN && copy.depth != 0.f) {
+                active[activeCount++] = copy;
+                used[copy.source] = true;
+            }
+        }
+
+        float values[SOURCES_LEN] = {};
+        for (int i = 0; i < NUM_LFOS; ++i) {
+            if (used[LFO_1 + i])
+                values[LFO_1 + i] = lfos[i].process(deltaTime, prng);
+        }
+        for (int i = 0; i < NUM_ENVS; ++i) {
+            if (triggerPending)
+                envs[i].trigger();
+            if (used[ENV_1 + i])
+                values[ENV_1 + i] = envs[i].process(deltaTime);
+        }
+        triggerPending = false;
+
+        for (int i = 0; i < activeCount; ++i)
+            amounts[active[i].paramId] += active[i].depth * values[active[i].source];
+    }
+
+    json_t* toJson() {
+        json_t* rootJ = json_object();
+
+        json_t* lfosJ = json_array();
+        for (const Lfo& lfo : lfos) {
+            json_t* lfoJ = json_object();
+            json_object_set_new(lfoJ, "rate", json_real(lfo.rate));
+            json_object_set_new(lfoJ, "shape", json_integer(lfo.shape));
+            json_array_append_new(lfosJ, lfoJ);
+        }
+        json_object_set_new(rootJ, "lfos", lfosJ);
+
+        json_t* envsJ = json_array();
+        for (const Envelope& env : envs) {
+            json_t* envJ = json_object();
+            json_object_set_new(envJ, "attack", json_real(env.attack));
+            json_object_set_new(envJ, "decay", json_real(env.decay));
+            json_array_append_new(envsJ, envJ);
+        }
+        json_object_set_new(rootJ, "envs", envsJ);
+
+        json_t* routesJ = json_array();
+        for (const Route& route : routes) {
+            if (route.source < 0)
+                continue;
+            json_t* routeJ = json_object();
+            json_object_set_new(routeJ, "source", json_integer(route.source));
+            json_object_set_new(routeJ, "paramId", json_integer(route.paramId));
+            json_object_set_new(routeJ, "depth", json_real(route.depth));
+            json_array_append_new(routesJ, routeJ);
+        }
+        json_object_set_new(rootJ, "routes", routesJ);
+        return rootJ;
+    }
+
+    // paramsLen bounds the destinations so a patch from a newer version can't index past the params
+    void fromJson(json_t* rootJ, int paramsLen) {
+        json_t* lfosJ = json_object_get(rootJ, "lfos");
+        for (int i = 0; i < NUM_LFOS && i < (int) json_array_size(lfosJ); ++i) {
+            json_t* lfoJ = json_array_get(lfosJ, i);
+            json_t* rateJ = json_object_get(lfoJ, "rate");
+            if (rateJ)
+                lfos[i].rate = rack::math::clamp((float) json_number_value(rateJ), MIN_RATE, MAX_RATE);
+            json_t* shapeJ = json_object_get(lfoJ, "shape");
+            if (shapeJ)
+                lfos[i].shape = rack::math::clamp((int) json_integer_value(shapeJ), 0, LFO_SHAPES_LEN - 1);
+        }
+
+        json_t* envsJ = json_object_get(rootJ, "envs");
+        for (int i = 0; i < NUM_ENVS && i < (int) json_array_size(envsJ); ++i) {
+            json_t* envJ = json_array_get(envsJ, i);
+            json_t* attackJ = json_object_get(envJ, "attack");
+            if (attackJ)
+                envs[i].attack = rack::math::clamp((float) json_number_value(attackJ), MIN_TIME, MAX_TIME);
+            json_t* decayJ = json_object_get(envJ, "decay");
+            if (decayJ)
+                envs[i].decay = rack::math::clamp((float) json_number_value(decayJ), MIN_TIME, MAX_TIME);
+        }
+
+        for (Route& route : routes)
+            route.source = -1;
+        json_t* routesJ = json_object_get(rootJ, "routes");
+        for (int i = 0; i < (int) json_array_size(routesJ); ++i) {
+            json_t* routeJ = json_array_get(routesJ, i);
+            int source = json_integer_value(json_object_get(routeJ, "source"));
+            int paramId = json_integer_value(json_object_get(routeJ, "paramId"));
+            float depth = rack::math::clamp((float) json_number_value(json_object_get(routeJ, "depth")), -1.f, 1.f);
+            if (source >= 0 && source < SOURCES_LEN && paramId >= 0 && paramId < paramsLen)
+                addRoute(source, paramId, depth);
+        }
+    }
+};
@@ -1,18 +1,76 @@
 #include "plugin.hpp"
+#include "HutaraDsp.hpp"
 #include <random>
 
+// Phase-locked clock divider and multiplier.
+// Measures the input period between Schmitt-triggered rising edges, and every
+// `division` input clocks emits `multiplier` evenly spaced ticks, the first one
+// exactly on the input edge. O(1) per sample, so it follows audio-rate clocks.
+struct ClockEngine {
+    hutara::EdgeDetector<float> edge;
+    bool seenEdge = false;
+    uint32_t samplesSinceEdge = 0;
+    // Input period in samples, 0 until two edges have been seen
+    uint32_t period = 0;
+    int edgeCount = 0;
+
+    uint32_t samplesSinceLock = 0;
+    float tickPeriod = 0.f;
+    float nextTick = 0.f;
+    int ticksLeft = 0;
+
+    // Returns true on the samples where the output clock ticks
+    bool process(float in, float lowThreshold, int division, int multiplier) {
+        if (samplesSinceEdge < UINT32_MAX)
+            samplesSinceEdge++;
+        if (samplesSinceLock < UINT32_MAX)
+            samplesSinceLock++;
+
+        if (edge.process(in, lowThreshold, 1.f) > 0.f) {
+            if (seenEdge)
+                period = samplesSinceEdge;
+            seenEdge = true;
+            samplesSinceEdge = 0;
+
+            if (++edgeCount >= division) {
+                // Relock the multiplied clock to this edge
+                edgeCount = 0;
+                samplesSinceLock = 0;
+                tickPeriod = float(period) * division / multiplier;
+                nextTick = tickPeriod;
+                ticksLeft = (period > 0) ? multiplier - 1 : 0;
+                return true;
+            }
+        }
+
+        if (ticksLeft > 0 && samplesSinceLock >= nextTick) {
+            ticksLeft--;
+            nextTick += tickPeriod;
+            return true;
+        }
+        return false;
+    }
+
+    // Output clock period in samples, 0 while the input period is unknown
+    float getTickPeriod() {
+        return tickPeriod;
+    }
+};
+
 // Define the module class
 struct Hutara_Random_CV : Module {
     static constexpr float DEFAULT_FREQ = 1.0f;
     static constexpr float DEFAULT_GATE_LENGTH = 0.5f;
     static constexpr float CLOCK_ACTIVE_THRESHOLD = 0.1f;
+    // Chance that a clock opens the gate
+    static constexpr float GATE_PROBABILITY = 0.5f;
 
-    float phase = 0.f;
-    float freq = DEFAULT_FREQ;
     float outputVoltage = 0.0f;
-    bool sampleNext = false;
     bool bipolarOutput = true;
-    std::mt19937 randomGenerator;
+    hutara::Prng randomGenerator;
+    ClockEngine clock;
+    // Samples left on the current gate
+    float gateSamplesLeft = 0.f;
 
     enum ParamIds {
         OUTPUT_VOLTAGE_PARAM,
@@ -42,10 +100,10 @@ struct Hutara_Random_CV : Module {
         config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS);
         configParam(OUTPUT_VOLTAGE_PARAM, 0.25f, 10.f, 5.f, "S&H Voltage");
         configParam(BIPOLAR_PARAM, 0.f, 1.f, 1.f, "1 Bipolar/0 Unipolar");
-        configParam(RANDOM_GATE_SPEED_PARAM, 1, 3, 2, "Random Gate Speed");
-        configParam(GATE_LENGTH_PARAM, 0.01f, 1.0f, DEFAULT_GATE_LENGTH, "Gate Length");
+        configSwitch(RANDOM_GATE_SPEED_PARAM, 1, 3, 2, "Clock Rate", {"x1/2", "x1", "x2"});
+        configParam(GATE_LENGTH_PARAM, 0.01f, 1.0f, DEFAULT_GATE_LENGTH, "Gate Length", "% of clock", 0.f, 100.f);
         configParam(STRENGTH_PARAM, 1.f, 10.f, 5.f, "Modulation Strength");
-        configParam(TRIGGER_DIVISION_DIVIDER_PARAM, 1, 3, 1, "Trigger Division");
+        configSwitch(TRIGGER_DIVISION_DIVIDER_PARAM, 1, 3, 1, "Trigger Division", {"1/1", "1/2", "1/3"});
         configParam(S_H_OFFSET_PARAM, -5.f, 5.f, 0.f, "S&H Offset"); // Configure S&H Offset
         configOutput(GATE_OUTPUT, "Gate");
         configOutput(OUTPUT, "S&H");
@@ -54,7 +112,7 @@ struct Hutara_Random_CV : Module {
 
         // Seed the random number generator
         std::random_device rd;
-        randomGenerator.seed(rd());
+        randomGenerator.seed((uint64_t(rd()) << 32) | rd(), (uint64_t(rd()) << 32) | rd());
     }
 
     // Process function to handle the module's behavior
@@ -63,36 +121,14 @@ struct Hutara_Random_CV : Module {
         bipolarOutput = params[BIPOLAR_PARAM].getValue() > 0.5f;
         float strength = params[STRENGTH_PARAM].getValue();
         float gateLength = params[GATE_LENGTH_PARAM].getValue();
-        int gateSpeedParam = round(params[RANDOM_GATE_SPEED_PARAM].getValue());
-        int triggerDivisionDivider = round(params[TRIGGER_DIVISION_DIVIDER_PARAM].getValue());
+        // The rate switch halves or doubles the clock, its default middle position
+        // keeps one S&H per clock as before
+        int rate = int(std::round(params[RANDOM_GATE_SPEED_PARAM].getValue()));
+        int multiplier = (rate >= 3) ? 2 : 1;
+        int division = int(std::round(params[TRIGGER_DIVISION_DIVIDER_PARAM].getValue())) * ((rate <= 1) ? 2 : 1);
         float offset = params[S_H_OFFSET_PARAM].getValue(); // Retrieve the S&H offset
 
-        float gateSpeed = 1.0f;
-
-        if (inputs[ON_INPUT].isConnected()) {
-            float onInputVoltage = inputs[ON_INPUT].getVoltage();
-            if (std::abs(onInputVoltage) > CLOCK_ACTIVE_THRESHOLD) {
-                gateSpeed = clamp(1.0f - std::abs(clamp(1.0f / onInputVoltage, 0.0f, 10.0f)), 0.1f, 1.0f);
-            }
-
-            // Apply trigger division here
-            gateSpeed /= triggerDivisionDivider;
-            gateSpeed = clamp(gateSpeed, 0.1f, 1.0f);
-
-            switch (gateSpeedParam) {
-                case 1:
-                    gateSpeed *= onInputVoltage / 4.0f;
-                    break;
-                case 2:
-                    gateSpeed *= onInputVoltage / 2.0f;
-                    break;
-                case 3:
-                    gateSpeed = onInputVoltage;
-                    break;
-            }
-        }
-
-        if (inputs[ON_INPUT].getVoltage() >= 1.0f && !sampleNext) {
+        if (clock.process(inputs[ON_INPUT].getVoltage(), CLOCK_ACTIVE_THRESHOLD, division, multiplier)) {
             float randomValue = generateRandomFloat() * strength;
             if (bipolarOutput) {
                 randomValue *= outputVoltage;
@@ -101,41 +137,29 @@ struct Hutara_Random_CV : Module {
             }
             randomValue = clamp(randomValue, bipolarOutput ? -outputVoltage : 0.0f, outputVoltage);
             randomValue += offset; // Apply the offset to the sampled value
-            sampleNext = true;
             outputs[OUTPUT].setVoltage(randomValue);
 
-            float randomGate = (generateRandomFloat() < gateLength) ? 10.0f : 0.0f;
-            switch (gateSpeedParam) {
-                case 1:
-                    randomGate = (generateRandomFloat() < gateLength * 0.25f) ? 10.0f : 0.0f;
-                    break;
-                case 2:
-                    randomGate = (generateRandomFloat() < gateLength * 0.125f) ? 10.0f : 0.0f;
-                    break;
-                case 3:
-                    randomGate = (generateRandomFloat() < gateLength * 0.625f) ? 10.0f : 0.0f;
-                    break;
-            }
-
-            outputs[GATE_OUTPUT].setVoltage(randomGate);
-            outputs[GATE_OUTPUT_INVERTED].setVoltage(10.0f - randomGate);
+            // Each clock opens the gate with GATE_PROBABILITY, the gate lasts a fraction of the measured clock period
+            // (of DEFAULT_FREQ until two clocks have been seen)
+            float tickPeriod = clock.getTickPeriod();
+            if (tickPeriod <= 0.f)
+                tickPeriod = args.sampleRate / DEFAULT_FREQ;
+            if (randomGenerator.uniform<float>() < GATE_PROBABILITY)
+                gateSamplesLeft = std::max(gateLength * tickPeriod, 1.f);
+            else
+                gateSamplesLeft = 0.f;
         }
 
-        if (inputs[ON_INPUT].getVoltage() < 1.0f && sampleNext) {
-            sampleNext = false;
-        }
+        float randomGate = (gateSamplesLeft > 0.f) ? 10.0f : 0.0f;
+        gateSamplesLeft -= 1.f;
+        outputs[GATE_OUTPUT].setVoltage(randomGate);
+        outputs[GATE_OUTPUT_INVERTED].setVoltage(10.0f - randomGate);
     }
 
 private:
-    // Clamp a value between a minimum and maximum
-    float clamp(float value, float min, float max) {
-        return std::min(std::max(value, min), max);
-    }
-
     // Generate a random float between -1.0 and 1.0
     float generateRandomFloat() {
-        std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
-        return distribution(randomGenerator);
+        return randomGenerator.bipolar<float>();
     }
 };
 
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+
+// Wait-free single-producer/single-consumer queue with a fixed power-of-two size.
+// One thread may push() and one other thread may pop(), neither ever blocks or allocates.
+// When the queue is full push() drops the new value, so the producer stays real-time safe.
+template <typename T, size_t S>
+struct SpscRingBuffer {
+    static_assert(S > 0 && (S & (S - 1)) == 0, "SpscRingBuffer size must be a power of two");
+
+    T data[S];
+    // Free-running counters, only their difference and the low bits matter
+    std::atomic<size_t> writeIndex{0};
+    std::atomic<size_t> readIndex{0};
+
+    // Producer side
+    bool push(T t) {
+        size_t w = writeIndex.load(std::memory_order_relaxed);
+        if (w - readIndex.load(std::memory_order_acquire) >= S)
+            return false;
+        data[w & (S - 1)] = t;
+        writeIndex.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, copies up to n values into out and returns how many were copied
+    size_t pop(T* out, size_t n) {
+        size_t r = readIndex.load(std::memory_order_relaxed);
+        n = std::min(n, writeIndex.load(std::memory_order_acquire) - r);
+        for (size_t i = 0; i < n; ++i)
+            out[i] = data[(r + i) & (S - 1)];
+        readIndex.store(r + n, std::memory_order_release);
+        return n;
+    }
+
+    // Consumer side
+    size_t size() {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_relaxed);
+    }
+};
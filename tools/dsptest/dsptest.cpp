@@ -0,0 +1,202 @@
+// Checks for the shared DSP core in src/HutaraDsp.hpp, built against the Rack
+// stand-in of tools/sweep. Every kernel runs on float_4 lanes and on each lane
+// as a plain float, and both must agree, plus a few known values per kernel.
+//
+// The stand-in's float_4 sin/cos/pow are std:: per lane, so the lane checks
+// only cover the mask and lane logic, not the transcendentals. The reference
+// values in testReferenceValues() are computed in double precision and hold
+// both paths to the exact maths.
+#include "HutaraDsp.hpp"
+
+#include <cstdio>
+
+using rack::simd::float_4;
+
+static int checks = 0;
+static int failures = 0;
+
+static void checkClose(const char* name, float actual, float expected, float tolerance = 1e-6f) {
+    checks++;
+    if (!(std::fabs(actual - expected) <= tolerance)) {
+        failures++;
+        std::printf("FAIL %s: got %.9g, expected %.9g\n", name, actual, expected);
+    }
+}
+
+// Runs kernel once on float_4 and once per lane on float, the lanes must match
+template <typename Kernel>
+static void checkLanes(const char* name, Kernel kernel, float_4 a, float_4 b = 0.f) {
+    float_4 vector = kernel(a, b);
+    for (int i = 0; i < 4; ++i)
+        checkClose(name, vector[i], kernel(a[i], b[i]));
+}
+
+static void testOscillators() {
+    checkClose("advancePhase", hutara::advancePhase(0.2f, 0.3f), 0.5f);
+    // Wraps back into [0, 1)
+    checkClose("advancePhase wrap", hutara::advancePhase(0.9f, 0.2f), 0.1f, 1e-6f);
+    checkClose("advancePhase wrap at 1", hutara::advancePhase(0.5f, 0.5f), 0.f);
+    checkClose("sineWave", hutara::sineWave(0.25f), 1.f);
+    checkClose("sawWave", hutara::sawWave(0.5f), 1.f);
+    checkClose("triangleWave 0", hutara::triangleWave(0.f), 1.f);
+    checkClose("triangleWave 0.5", hutara::triangleWave(0.5f), -1.f);
+    checkClose("squareWave low", hutara::squareWave(0.25f), -1.f);
+    checkClose("squareWave high", hutara::squareWave(0.75f), 1.f);
+
+    float_4 phases[] = {float_4(0.f, 0.2f, 0.5f, 0.99f), float_4(0.25f, 0.49f, 0.51f, 0.75f)};
+    for (float_4 phase : phases) {
+        checkLanes("advancePhase lanes", [](auto p, auto i) {return hutara::advancePhase(p, i);}, phase, float_4(0.01f, 0.3f, 0.5f, 0.02f));
+        checkLanes("sineWave lanes", [](auto p, auto) {return hutara::sineWave(p);}, phase);
+        checkLanes("sawWave lanes", [](auto p, auto) {return hutara::sawWave(p);}, phase);
+        checkLanes("triangleWave lanes", [](auto p, auto) {return hutara::triangleWave(p);}, phase);
+        checkLanes("squareWave lanes", [](auto p, auto) {return hutara::squareWave(p);}, phase);
+    }
+}
+
+static void testShapers() {
+    hutara::Shaper<float> psychedelic = hutara::psychedelicShaper();
+    hutara::Shaper<float> saw = hutara::sawShaper();
+    hutara::Shaper<float> flat = {0.f, 0.f, 0.f};
+
+    // Amount 0 leaves the input untouched, amount 1 is the bare curve
+    checkClose("shaper amount 0", psychedelic.process(0.3f, 0.f), 0.3f);
+    checkClose("psychedelicShaper at 0", psychedelic.process(0.f, 1.f), 0.5f);
+    checkClose("sawShaper at 0", saw.process(0.f, 1.f), 0.4f);
+
+    // Each lane of the packed shaper runs the scalar shaper of that lane
+    hutara::Shaper<float_4> lanes = hutara::laneShapers(psychedelic, saw, psychedelic, flat);
+    hutara::Shaper<float> scalars[] = {psychedelic, saw, psychedelic, flat};
+    float_4 xs[] = {float_4(-1.f, -0.3f, 0.4f, 1.f), float_4(0.7f, 1.f, -0.9f, 0.1f)};
+    float_4 amount = float_4(0.25f, -0.5f, 1.f, 0.f);
+    for (float_4 x : xs) {
+        float_4 shaped = lanes.process(x, amount);
+        for (int i = 0; i < 4; ++i)
+            checkClose("laneShapers lanes", shaped[i], scalars[i].process(x[i], amount[i]), 1e-5f);
+    }
+}
+
+static void testResampling() {
+    checkClose("sinc(0)", hutara::sinc(0.f), 1.f);
+    checkClose("sinc(1)", hutara::sinc(1.f), 0.f, 1e-6f);
+    checkClose("sinc(0.5)", hutara::sinc(0.5f), float(2 / M_PI));
+    checkLanes("sinc lanes", [](auto x, auto) {return hutara::sinc(x);}, float_4(0.f, 0.5f, -1.5f, 3.25f));
+
+    // On a table index the sinc taps vanish except the centre one, 0.4 + window(0) * table[0]
+    checkClose("resampleSquare on index", hutara::resampleSquare(-1.f, 0.5f), 0.48f);
+    float_4 xs[] = {float_4(-1.f, -0.3f, 0.4f, 1.f), float_4(0.f, 0.5f, -0.7f, 0.9f)};
+    for (float_4 x : xs) {
+        checkLanes("resampleSquare lanes", [](auto x, auto cv) {return hutara::resampleSquare(x, cv);}, x, float_4(0.f, 0.5f, 1.3f, -0.2f));
+    }
+}
+
+static void testMixing() {
+    checkClose("sum", hutara::sum(float_4(1.f, 2.f, 3.f, 4.f)), 10.f);
+
+    float left, right;
+    hutara::StereoBus bus;
+    bus.process(float_4(1.f, 0.f, 0.f, 0.f), left, right);
+    checkClose("StereoBus default centre left", left, float(M_SQRT1_2));
+    checkClose("StereoBus default centre right", right, float(M_SQRT1_2));
+    bus.setPan(float_4(-1.f, 1.f, 0.f, 5.f));
+    bus.process(float_4(1.f, 0.f, 0.f, 0.f), left, right);
+    checkClose("StereoBus hard left", left, 1.f);
+    checkClose("StereoBus hard left right", right, 0.f);
+    // Out of range pan is clamped to hard right
+    bus.process(float_4(0.f, 0.f, 0.f, 1.f), left, right);
+    checkClose("StereoBus clamped left", left, 0.f);
+    checkClose("StereoBus clamped right", right, 1.f);
+}
+
+static void testPrng() {
+    hutara::Prng a, b;
+    a.seed(1, 2);
+    b.seed(1, 2);
+    // A float_4 draw takes the next four scalar draws in lane order
+    for (int n = 0; n < 100; ++n) {
+        float_4 vector = a.uniform<float_4>();
+        for (int i = 0; i < 4; ++i) {
+            float scalar = b.uniform<float>();
+            checkClose("Prng lanes", vector[i], scalar, 0.f);
+            checks++;
+            if (!(scalar >= 0.f && scalar < 1.f)) {
+                failures++;
+                std::printf("FAIL Prng range: %g\n", scalar);
+            }
+        }
+    }
+    checkClose("Prng bipolar", a.bipolar<float>(), 2.f * b.uniform<float>() - 1.f, 0.f);
+}
+
+static void testEdgeDetector() {
+    hutara::EdgeDetector<float> edge;
+    checkClose("edge below high", edge.process(0.5f), 0.f);
+    checkClose("edge rising", edge.process(1.f), 1.f);
+    checkClose("edge stays high", edge.process(0.5f), 0.f);
+    checkClose("edge no retrigger", edge.process(1.f), 0.f);
+    // Exactly at the low threshold is not below it, so the edge does not rearm
+    edge.process(0.1f);
+    checkClose("edge at low threshold", edge.process(1.f), 0.f);
+    edge.process(0.05f);
+    checkClose("edge rearmed", edge.isHigh(), 0.f);
+    checkClose("edge rising again", edge.process(1.f), 1.f);
+    edge.reset();
+    checkClose("edge reset", edge.process(1.f), 1.f);
+
+    // Lanes follow their own inputs like separate scalar detectors
+    hutara::EdgeDetector<float_4> vector;
+    hutara::EdgeDetector<float> scalars[4];
+    hutara::Prng prng;
+    for (int n = 0; n < 1000; ++n) {
+        float_4 in = 1.2f * prng.uniform<float_4>();
+        float_4 rising = vector.process(in);
+        for (int i = 0; i < 4; ++i)
+            checkClose("EdgeDetector lanes", rising[i], scalars[i].process(in[i]), 0.f);
+    }
+}
+
+// Reference values at non-trivial points, computed in double precision from
+// the kernel formulas
+static void testReferenceValues() {
+    const float tolerance = 2e-5f;
+
+    // psychedelicShaper on sineWave(0.1) at amount 0.6, sawShaper on sawWave(0.37) at 0.5,
+    // psychedelicShaper on triangleWave(0.3) at -0.4 and on sineWave(0.83) at 1
+    const float shapedReference[4] = {-0.2624280068700978f, 0.43254290963000597f, 0.11021130325903084f, -0.2777277565801557f};
+    hutara::Shaper<float> psychedelic = hutara::psychedelicShaper();
+    hutara::Shaper<float> saw = hutara::sawShaper();
+    hutara::Shaper<float> shapers[] = {psychedelic, saw, psychedelic, psychedelic};
+    float_4 phase = float_4(0.1f, 0.37f, 0.3f, 0.83f);
+    float_4 amount = float_4(0.6f, 0.5f, -0.4f, 1.f);
+
+    float scalarWaves[4] = {hutara::sineWave(phase[0]), hutara::sawWave(phase[1]), hutara::triangleWave(phase[2]), hutara::sineWave(phase[3])};
+    float_4 sines = hutara::sineWave(phase);
+    float_4 vectorWaves = float_4(sines[0], hutara::sawWave(phase)[1], hutara::triangleWave(phase)[2], sines[3]);
+    float_4 shaped = hutara::laneShapers(psychedelic, saw, psychedelic, psychedelic).process(vectorWaves, amount);
+    for (int i = 0; i < 4; ++i) {
+        checkClose("shaped waveform reference", shapers[i].process(scalarWaves[i], amount[i]), shapedReference[i], tolerance);
+        checkClose("shaped waveform reference lanes", shaped[i], shapedReference[i], tolerance);
+    }
+
+    // Between table indices and with cv != 0, so several sinc taps contribute
+    const float resampleReference[4] = {0.42935773301345004f, 0.26823907561055715f, -0.04092947203200174f, 0.738159532553597f};
+    float_4 x = float_4(-0.3f, 0.55f, -0.9f, 0.2f);
+    float_4 cv = float_4(0.35f, 0.8f, 1.3f, -0.15f);
+    float_4 resampled = hutara::resampleSquare(x, cv);
+    for (int i = 0; i < 4; ++i) {
+        checkClose("resampleSquare reference", hutara::resampleSquare(x[i], cv[i]), resampleReference[i], tolerance);
+        checkClose("resampleSquare reference lanes", resampled[i], resampleReference[i], tolerance);
+    }
+}
+
+int main() {
+    testOscillators();
+    testShapers();
+    testResampling();
+    testMixing();
+    testPrng();
+    testEdgeDetector();
+    testReferenceValues();
+
+    std::printf("%d of %d checks passed\n", checks - failures, checks);
+    return failures ? 1 : 0;
+}
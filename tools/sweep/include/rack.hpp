@@ -0,0 +1,385 @@
+#pragma once
+// Minimal headless stand-in for the parts of the Rack SDK that the module
+// engines use. Only enough to run Module::process() offline, no UI.
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <emmintrin.h>
+
+
+// Patch storage is not used offline, the JSON hooks only need to compile.
+// Global like jansson's API, which Rack includes outside its namespace.
+struct json_t;
+
+inline json_t* json_object() {
+    return nullptr;
+}
+inline json_t* json_boolean(bool value) {
+    return nullptr;
+}
+inline json_t* json_array() {
+    return nullptr;
+}
+inline json_t* json_integer(long long value) {
+    return nullptr;
+}
+inline json_t* json_real(double value) {
+    return nullptr;
+}
+inline int json_array_append_new(json_t* array, json_t* value) {
+    return -1;
+}
+inline size_t json_array_size(const json_t* array) {
+    return 0;
+}
+inline json_t* json_array_get(const json_t* array, size_t index) {
+    return nullptr;
+}
+inline long long json_integer_value(const json_t* json) {
+    return 0;
+}
+inline double json_number_value(const json_t* json) {
+    return 0.0;
+}
+inline int json_object_set_new(json_t* object, const char* key, json_t* value) {
+    return -1;
+}
+inline json_t* json_object_get(const json_t* object, const char* key) {
+    return nullptr;
+}
+inline bool json_is_true(const json_t* json) {
+    return false;
+}
+
+namespace rack {
+
+static const int PORT_MAX_CHANNELS = 16;
+
+namespace math {
+
+inline int clamp(int x, int a, int b) {
+    return std::max(std::min(x, b), a);
+}
+
+inline float clamp(float x, float a = 0.f, float b = 1.f) {
+    return std::fmax(std::fmin(x, b), a);
+}
+
+} // namespace math
+
+using namespace math;
+
+namespace simd {
+
+// 4 x float SSE vector, comparisons return all-ones/all-zeros lane masks.
+// Like Rack's, the default constructor leaves the lanes uninitialized.
+struct float_4 {
+    __m128 v;
+
+    float_4() = default;
+    float_4(__m128 v) : v(v) {}
+    float_4(float x) : v(_mm_set1_ps(x)) {}
+    float_4(float x1, float x2, float x3, float x4) : v(_mm_setr_ps(x1, x2, x3, x4)) {}
+
+    static float_4 zero() {
+        return float_4(_mm_setzero_ps());
+    }
+    static float_4 mask() {
+        return float_4(_mm_castsi128_ps(_mm_set1_epi32(-1)));
+    }
+    static float_4 load(const float* x) {
+        return float_4(_mm_loadu_ps(x));
+    }
+    void store(float* x) {
+        _mm_storeu_ps(x, v);
+    }
+    float& operator[](int i) {
+        return reinterpret_cast<float*>(&v)[i];
+    }
+    const float& operator[](int i) const {
+        return reinterpret_cast<const float*>(&v)[i];
+    }
+};
+
+#define HUTARA_SIMD_BINARY(op, fn) \
+    inline float_4 operator op(const float_4& a, const float_4& b) { return float_4(fn(a.v, b.v)); } \
+    inline float_4 operator op(float a, const float_4& b) { return float_4(a) op b; } \
+    inline float_4 operator op(const float_4& a, float b) { return a op float_4(b); }
+
+HUTARA_SIMD_BINARY(+, _mm_add_ps)
+HUTARA_SIMD_BINARY(-, _mm_sub_ps)
+HUTARA_SIMD_BINARY(*, _mm_mul_ps)
+HUTARA_SIMD_BINARY(/, _mm_div_ps)
+HUTARA_SIMD_BINARY(==, _mm_cmpeq_ps)
+HUTARA_SIMD_BINARY(!=, _mm_cmpneq_ps)
+HUTARA_SIMD_BINARY(<, _mm_cmplt_ps)
+HUTARA_SIMD_BINARY(<=, _mm_cmple_ps)
+HUTARA_SIMD_BINARY(>, _mm_cmpgt_ps)
+HUTARA_SIMD_BINARY(>=, _mm_cmpge_ps)
+HUTARA_SIMD_BINARY(&, _mm_and_ps)
+HUTARA_SIMD_BINARY(|, _mm_or_ps)
+HUTARA_SIMD_BINARY(^, _mm_xor_ps)
+
+#undef HUTARA_SIMD_BINARY
+
+inline float_4 operator-(const float_4& a) {
+    return 0.f - a;
+}
+inline float_4 operator~(const float_4& a) {
+    return a ^ float_4::mask();
+}
+inline float_4& operator+=(float_4& a, const float_4& b) {
+    return a = a + b;
+}
+inline float_4& operator-=(float_4& a, const float_4& b) {
+    return a = a - b;
+}
+inline float_4& operator*=(float_4& a, const float_4& b) {
+    return a = a * b;
+}
+inline float_4& operator/=(float_4& a, const float_4& b) {
+    return a = a / b;
+}
+
+inline float_4 ifelse(const float_4& mask, const float_4& a, const float_4& b) {
+    return (mask & a) | _mm_andnot_ps(mask.v, b.v);
+}
+inline float ifelse(bool cond, float a, float b) {
+    return cond ? a : b;
+}
+inline int movemask(const float_4& a) {
+    return _mm_movemask_ps(a.v);
+}
+
+inline float_4 fmin(const float_4& a, const float_4& b) {
+    return float_4(_mm_min_ps(a.v, b.v));
+}
+inline float_4 fmax(const float_4& a, const float_4& b) {
+    return float_4(_mm_max_ps(a.v, b.v));
+}
+inline float_4 fabs(const float_4& a) {
+    return float_4(_mm_andnot_ps(_mm_set1_ps(-0.f), a.v));
+}
+
+// Transcendentals lane by lane with std:: (see the README on accuracy)
+#define HUTARA_SIMD_UNARY(name, fn) \
+    inline float_4 name(const float_4& a) { return float_4(fn(a[0]), fn(a[1]), fn(a[2]), fn(a[3])); }
+
+HUTARA_SIMD_UNARY(floor, std::floor)
+HUTARA_SIMD_UNARY(round, std::round)
+HUTARA_SIMD_UNARY(sin, std::sin)
+HUTARA_SIMD_UNARY(cos, std::cos)
+HUTARA_SIMD_UNARY(exp, std::exp)
+HUTARA_SIMD_UNARY(log, std::log)
+HUTARA_SIMD_UNARY(sqrt, std::sqrt)
+
+#undef HUTARA_SIMD_UNARY
+
+inline float_4 pow(float a, const float_4& b) {
+    return float_4(std::pow(a, b[0]), std::pow(a, b[1]), std::pow(a, b[2]), std::pow(a, b[3]));
+}
+
+inline float_4 clamp(const float_4& x, const float_4& a = 0.f, const float_4& b = 1.f) {
+    return fmax(fmin(x, b), a);
+}
+
+// Scalar overloads so templated kernels can call simd:: for both sample types
+using std::floor;
+using std::round;
+using std::sin;
+using std::cos;
+using std::exp;
+using std::log;
+using std::sqrt;
+using std::fmin;
+using std::fmax;
+using std::fabs;
+using std::pow;
+using math::clamp;
+
+} // namespace simd
+
+struct Param {
+    float value = 0.f;
+
+    float getValue() {
+        return value;
+    }
+    void setValue(float value) {
+        this->value = value;
+    }
+};
+
+struct Port {
+    float voltages[PORT_MAX_CHANNELS] = {};
+    uint8_t channels = 0;
+
+    float getVoltage(int channel = 0) {
+        return voltages[channel];
+    }
+    void setVoltage(float voltage, int channel = 0) {
+        voltages[channel] = voltage;
+    }
+    float getPolyVoltage(int channel) {
+        return isMonophonic() ? voltages[0] : voltages[channel];
+    }
+    template <typename T>
+    T getVoltageSimd(int firstChannel) {
+        return T::load(&voltages[firstChannel]);
+    }
+    template <typename T>
+    T getPolyVoltageSimd(int firstChannel) {
+        return isMonophonic() ? T(voltages[0]) : getVoltageSimd<T>(firstChannel);
+    }
+    int getChannels() {
+        return channels;
+    }
+    bool isMonophonic() {
+        return channels == 1;
+    }
+    // As in Rack, an unpatched port stays at 0 channels, and dropped channels are zeroed
+    void setChannels(int channels) {
+        if (this->channels == 0)
+            return;
+        for (int c = channels; c < this->channels; c++)
+            voltages[c] = 0.f;
+        if (channels == 0)
+            channels = 1;
+        this->channels = channels;
+    }
+    bool isConnected() {
+        return channels > 0;
+    }
+};
+
+struct Input : Port {};
+
+struct Output : Port {};
+
+struct Light {
+    float value = 0.f;
+
+    float getBrightness() {
+        return value;
+    }
+    void setBrightness(float brightness) {
+        value = brightness;
+    }
+    void setBrightnessSmooth(float brightness, float deltaTime, float lambda = 30.f) {
+        if (brightness < value) {
+            // Fade out light
+            value += (brightness - value) * lambda * deltaTime;
+        } else {
+            // Immediately illuminate light
+            value = brightness;
+        }
+    }
+};
+
+struct ParamQuantity {
+    float minValue = 0.f;
+    float maxValue = 1.f;
+    float defaultValue = 0.f;
+    std::string name;
+
+    float getMinValue() {
+        return minValue;
+    }
+    float getMaxValue() {
+        return maxValue;
+    }
+    float getDefaultValue() {
+        return defaultValue;
+    }
+    std::string getLabel() {
+        return name;
+    }
+};
+
+struct Module {
+    std::vector<Param> params;
+    std::vector<Input> inputs;
+    std::vector<Output> outputs;
+    std::vector<Light> lights;
+    std::vector<ParamQuantity*> paramQuantities;
+
+    struct ProcessArgs {
+        float sampleRate;
+        float sampleTime;
+        int64_t frame;
+    };
+
+    virtual ~Module() {
+        for (ParamQuantity* pq : paramQuantities)
+            delete pq;
+    }
+
+    void config(int numParams, int numInputs, int numOutputs, int numLights = 0) {
+        params.resize(numParams);
+        inputs.resize(numInputs);
+        outputs.resize(numOutputs);
+        lights.resize(numLights);
+        paramQuantities.resize(numParams);
+        for (ParamQuantity*& pq : paramQuantities)
+            pq = new ParamQuantity;
+    }
+    ParamQuantity* configParam(int paramId, float minValue, float maxValue, float defaultValue, std::string name = "", std::string unit = "") {
+        ParamQuantity* pq = paramQuantities[paramId];
+        pq->minValue = minValue;
+        pq->maxValue = maxValue;
+        pq->defaultValue = defaultValue;
+        pq->name = name;
+        params[paramId].setValue(defaultValue);
+        return pq;
+    }
+    void configInput(int portId, std::string name = "") {}
+    void configOutput(int portId, std::string name = "") {}
+    void configLight(int lightId, std::string name = "") {}
+
+    virtual void process(const ProcessArgs& args) {}
+    virtual void onReset() {}
+    virtual json_t* dataToJson() {
+        return nullptr;
+    }
+    virtual void dataFromJson(json_t* rootJ) {}
+};
+
+struct Model {};
+
+struct Plugin {};
+
+namespace dsp {
+
+static const float FREQ_C4 = 261.6256f;
+
+struct ClockDivider {
+    uint32_t clock = 0;
+    uint32_t division = 1;
+
+    void reset() {
+        clock = 0;
+    }
+    void setDivision(uint32_t division) {
+        this->division = division;
+    }
+    uint32_t getDivision() {
+        return division;
+    }
+    uint32_t getClock() {
+        return clock;
+    }
+    bool process() {
+        clock++;
+        if (clock >= division) {
+            clock = 0;
+            return true;
+        }
+        return false;
+    }
+};
+
+} // namespace dsp
+
+} // namespace rack
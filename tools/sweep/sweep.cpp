@@ -0,0 +1,609 @@
+// Headless parameter-sweep renderer for FmOperator.
+//
+// Renders every point of a grid of param/input settings with the plugin's own
+// FmOperator engine (built against the Rack stand-in in include/), writes one
+// WAV per render and streams spectral statistics to stats.csv.
+//
+// Renders are independent, so they are spread over a pool of workers. Each
+// worker owns a contiguous range of job indices and takes from its front; an
+// idle worker steals the back half of the busiest-looking victim's range.
+#include "FmOperator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+struct NamedId {
+    const char* name;
+    int id;
+};
+
+static const NamedId paramNames[] = {
+    {"PITCH_PARAM_SINE", FmOperator::PITCH_PARAM_SINE},
+    {"PITCH_PARAM_SAW", FmOperator::PITCH_PARAM_SAW},
+    {"PITCH_PARAM_TRIANGLE", FmOperator::PITCH_PARAM_TRIANGLE},
+    {"PITCH_PARAM_SQUARE", FmOperator::PITCH_PARAM_SQUARE},
+    {"FM_PARAM", FmOperator::FM_PARAM},
+    {"SINE_WAVESHAPER_PARAM", FmOperator::SINE_WAVESHAPER_PARAM},
+    {"SAW_WAVESHAPER_PARAM", FmOperator::SAW_WAVESHAPER_PARAM},
+    {"PSYCHEDELIC_PARAM_TRIANGLE", FmOperator::PSYCHEDELIC_PARAM_TRIANGLE},
+    {"PSYCHEDELIC_CV_KNOB_PARAM", FmOperator::PSYCHEDELIC_CV_KNOB_PARAM},
+    {"FM_AMOUNT_PARAM", FmOperator::FM_AMOUNT_PARAM},
+    {"VOLUME_PARAM_SINE", FmOperator::VOLUME_PARAM_SINE},
+    {"VOLUME_PARAM_SAW", FmOperator::VOLUME_PARAM_SAW},
+    {"VOLUME_PARAM_TRIANGLE", FmOperator::VOLUME_PARAM_TRIANGLE},
+    {"VOLUME_PARAM_SQUARE", FmOperator::VOLUME_PARAM_SQUARE},
+    {"RESAMPLE", FmOperator::RESAMPLE},
+    {"PAN_PARAM_SINE", FmOperator::PAN_PARAM_SINE},
+    {"PAN_PARAM_SAW", FmOperator::PAN_PARAM_SAW},
+    {"PAN_PARAM_TRIANGLE", FmOperator::PAN_PARAM_TRIANGLE},
+    {"PAN_PARAM_SQUARE", FmOperator::PAN_PARAM_SQUARE},
+    {"ATTACK_PARAM", FmOperator::ATTACK_PARAM},
+    {"RELEASE_PARAM", FmOperator::RELEASE_PARAM},
+};
+
+static const NamedId inputNames[] = {
+    {"PITCH_INPUT_SINE", FmOperator::PITCH_INPUT_SINE},
+    {"PITCH_INPUT_SAW", FmOperator::PITCH_INPUT_SAW},
+    {"PITCH_INPUT_TRIANGLE", FmOperator::PITCH_INPUT_TRIANGLE},
+    {"PITCH_INPUT_SQUARE", FmOperator::PITCH_INPUT_SQUARE},
+    {"FM_INPUT", FmOperator::FM_INPUT},
+    {"FM_AMOUNT_INPUT", FmOperator::FM_AMOUNT_INPUT},
+    {"PSYCHEDELIC_CV_INPUT_SAW", FmOperator::PSYCHEDELIC_CV_INPUT_SAW},
+    {"PSYCHEDELIC_CV_INPUT_FOR_All", FmOperator::PSYCHEDELIC_CV_INPUT_FOR_All},
+    {"PSYCHEDELIC_CV_INPUT_TRIANGLE", FmOperator::PSYCHEDELIC_CV_INPUT_TRIANGLE},
+    {"RESAMPLE_INPUT", FmOperator::RESAMPLE_INPUT},
+    {"PITCH_INPUT_ALL", FmOperator::PITCH_INPUT_ALL},
+    {"MOD_TRIGGER_INPUT", FmOperator::MOD_TRIGGER_INPUT},
+    {"GATE_INPUT", FmOperator::GATE_INPUT},
+    {"VELOCITY_INPUT", FmOperator::VELOCITY_INPUT},
+};
+
+static const NamedId outputNames[] = {
+    {"SINE_OUTPUT", FmOperator::SINE_OUTPUT},
+    {"SAW_OUTPUT", FmOperator::SAW_OUTPUT},
+    {"TRIANGLE_OUTPUT", FmOperator::TRIANGLE_OUTPUT},
+    {"SQUARE_OUTPUT", FmOperator::SQUARE_OUTPUT},
+    {"FINAL_OUTPUT", FmOperator::FINAL_OUTPUT},
+    {"LEFT_OUTPUT", FmOperator::LEFT_OUTPUT},
+    {"RIGHT_OUTPUT", FmOperator::RIGHT_OUTPUT},
+};
+
+template <size_t N>
+static int findId(const NamedId (&table)[N], const std::string& name) {
+    for (const NamedId& entry : table) {
+        if (name == entry.name)
+            return entry.id;
+    }
+    return -1;
+}
+
+// A param or input that a sweep axis or a fixed setting writes to
+struct Target {
+    std::string name;
+    bool isInput = false;
+    int id = -1;
+
+    bool resolve(const std::string& name) {
+        this->name = name;
+        id = findId(paramNames, name);
+        isInput = false;
+        if (id < 0) {
+            id = findId(inputNames, name);
+            isInput = true;
+        }
+        return id >= 0;
+    }
+
+    void apply(FmOperator& module, float value) const {
+        if (isInput) {
+            module.inputs[id].setVoltage(value);
+            // Patch it the way Rack's engine does, setChannels() ignores unpatched ports
+            module.inputs[id].channels = 1;
+        } else {
+            module.params[id].setValue(value);
+        }
+    }
+};
+
+struct Axis {
+    Target target;
+    std::vector<float> values;
+};
+
+struct Settings {
+    std::string outDir = "sweep_out";
+    int threads = 0;
+    float sampleRate = 48000.f;
+    float duration = 2.f;
+    bool writeWav = true;
+    std::vector<std::pair<Target, float>> fixed;
+    std::vector<int> outputs;
+    std::vector<Axis> axes;
+};
+
+
+static bool parseFloat(const std::string& s, float& out) {
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtof(s.c_str(), &end);
+    return errno == 0 && end != s.c_str() && *end == '\0';
+}
+
+// VALUES is either a comma list "0,0.25,0.5" or a range "start:stop:count"
+static bool parseValues(const std::string& s, std::vector<float>& values) {
+    size_t colon = s.find(':');
+    if (colon != std::string::npos) {
+        size_t colon2 = s.find(':', colon + 1);
+        if (colon2 == std::string::npos)
+            return false;
+        float start, stop, count;
+        if (!parseFloat(s.substr(0, colon), start) ||
+            !parseFloat(s.substr(colon + 1, colon2 - colon - 1), stop) ||
+            !parseFloat(s.substr(colon2 + 1), count) || count < 1.f)
+            return false;
+        int n = static_cast<int>(count);
+        for (int i = 0; i < n; ++i) {
+            float t = (n > 1) ? static_cast<float>(i) / (n - 1) : 0.f;
+            values.push_back(start + t * (stop - start));
+        }
+        return true;
+    }
+
+    size_t begin = 0;
+    while (begin <= s.size()) {
+        size_t comma = s.find(',', begin);
+        if (comma == std::string::npos)
+            comma = s.size();
+        float value;
+        if (!parseFloat(s.substr(begin, comma - begin), value))
+            return false;
+        values.push_back(value);
+        begin = comma + 1;
+    }
+    return !values.empty();
+}
+
+static void printUsage(const char* argv0) {
+    std::fprintf(stderr,
+        "Usage: %s [options] NAME=VALUES ...\n"
+        "\n"
+        "Renders FmOperator for every combination of the given axes.\n"
+        "  NAME    FmOperator param or input id, e.g. FM_AMOUNT_PARAM, RESAMPLE_INPUT\n"
+        "  VALUES  comma list (0,0.2,0.4) or range start:stop:count (-0.5:0.6:12)\n"
+        "\n"
+        "Options:\n"
+        "  -o DIR          output directory (default sweep_out)\n"
+        "  -j N            worker threads (default: all cores)\n"
+        "  -r RATE         sample rate in Hz (default 48000)\n"
+        "  -d SECONDS      render length (default 2)\n"
+        "  -s NAME=VALUE   fix a param or input for every render (repeatable)\n"
+        "  -p OUTPUT       output port to render, one WAV channel each (repeatable,\n"
+        "                  default FINAL_OUTPUT)\n"
+        "  --no-wav        only write stats.csv\n",
+        argv0);
+}
+
+static bool parseArgs(int argc, char** argv, Settings& settings) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg == "--no-wav") {
+            settings.writeWav = false;
+        } else if (arg == "-o" && hasValue) {
+            settings.outDir = argv[++i];
+        } else if (arg == "-j" && hasValue) {
+            settings.threads = std::atoi(argv[++i]);
+        } else if (arg == "-r" && hasValue) {
+            if (!parseFloat(argv[++i], settings.sampleRate) || settings.sampleRate <= 0.f) {
+                std::fprintf(stderr, "Invalid sample rate %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "-d" && hasValue) {
+            if (!parseFloat(argv[++i], settings.duration) || settings.duration <= 0.f) {
+                std::fprintf(stderr, "Invalid duration %s\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "-p" && hasValue) {
+            int id = findId(outputNames, argv[++i]);
+            if (id < 0) {
+                std::fprintf(stderr, "Unknown output %s\n", argv[i]);
+                return false;
+            }
+            settings.outputs.push_back(id);
+        } else if (arg == "-s" && hasValue) {
+            std::string s = argv[++i];
+            size_t eq = s.find('=');
+            Target target;
+            float value;
+            if (eq == std::string::npos || !target.resolve(s.substr(0, eq)) || !parseFloat(s.substr(eq + 1), value)) {
+                std::fprintf(stderr, "Invalid setting %s\n", s.c_str());
+                return false;
+            }
+            settings.fixed.push_back({target, value});
+        } else {
+            size_t eq = arg.find('=');
+            Axis axis;
+            if (eq == std::string::npos || !axis.target.resolve(arg.substr(0, eq)) || !parseValues(arg.substr(eq + 1), axis.values)) {
+                std::fprintf(stderr, "Invalid axis %s\n", arg.c_str());
+                return false;
+            }
+            settings.axes.push_back(axis);
+        }
+    }
+
+    if (settings.outputs.empty())
+        settings.outputs.push_back(FmOperator::FINAL_OUTPUT);
+    if (settings.threads <= 0)
+        settings.threads = std::max(1u, std::thread::hardware_concurrency());
+    return true;
+}
+
+
+// Writes interleaved 32-bit float samples as a WAVE_FORMAT_IEEE_FLOAT file
+static bool writeWav(const std::string& path, const std::vector<float>& samples, int channels, int sampleRate) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f)
+        return false;
+
+    auto put16 = [&](uint16_t v) {
+        uint8_t b[2] = {uint8_t(v), uint8_t(v >> 8)};
+        std::fwrite(b, 1, 2, f);
+    };
+    auto put32 = [&](uint32_t v) {
+        uint8_t b[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)};
+        std::fwrite(b, 1, 4, f);
+    };
+
+    uint32_t frames = samples.size() / channels;
+    uint32_t dataSize = samples.size() * sizeof(float);
+    std::fwrite("RIFF", 1, 4, f);
+    put32(4 + (8 + 18) + (8 + 4) + (8 + dataSize));
+    std::fwrite("WAVE", 1, 4, f);
+
+    std::fwrite("fmt ", 1, 4, f);
+    put32(18);
+    put16(3); // WAVE_FORMAT_IEEE_FLOAT
+    put16(channels);
+    put32(sampleRate);
+    put32(sampleRate * channels * sizeof(float));
+    put16(channels * sizeof(float));
+    put16(32);
+    put16(0);
+
+    std::fwrite("fact", 1, 4, f);
+    put32(4);
+    put32(frames);
+
+    std::fwrite("data", 1, 4, f);
+    put32(dataSize);
+    for (float s : samples) {
+        uint32_t bits;
+        std::memcpy(&bits, &s, sizeof(bits));
+        put32(bits);
+    }
+
+    bool ok = !std::ferror(f);
+    return (std::fclose(f) == 0) && ok;
+}
+
+
+// In-place iterative radix-2 FFT, size must be a power of two
+static void fft(std::vector<std::complex<float>>& x) {
+    size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        float angle = -2.f * M_PI / len;
+        std::complex<float> wlen(std::cos(angle), std::sin(angle));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<float> w(1.f, 0.f);
+            for (size_t k = 0; k < len / 2; ++k) {
+                std::complex<float> u = x[i + k];
+                std::complex<float> v = x[i + k + len / 2] * w;
+                x[i + k] = u + v;
+                x[i + k + len / 2] = u - v;
+                w *= wlen;
+            }
+        }
+    }
+}
+
+struct Stats {
+    float rms = 0.f;
+    float peak = 0.f;
+    float dc = 0.f;
+    float centroid = 0.f;
+    float flatness = 0.f;
+    float rolloff = 0.f;
+};
+
+// Level statistics plus centroid, flatness and 85% rolloff of the averaged
+// Hann-windowed power spectrum
+static Stats analyze(const std::vector<float>& signal, float sampleRate) {
+    Stats stats;
+    if (signal.empty())
+        return stats;
+
+    double sum = 0.0, sumSquares = 0.0;
+    for (float s : signal) {
+        sum += s;
+        sumSquares += double(s) * s;
+        stats.peak = std::max(stats.peak, std::abs(s));
+    }
+    stats.dc = sum / signal.size();
+    stats.rms = std::sqrt(sumSquares / signal.size());
+
+    const size_t frameSize = 4096;
+    const size_t hop = frameSize / 2;
+    if (signal.size() < frameSize)
+        return stats;
+
+    std::vector<float> window(frameSize);
+    for (size_t i = 0; i < frameSize; ++i)
+        window[i] = 0.5f - 0.5f * std::cos(2.f * M_PI * i / (frameSize - 1));
+
+    std::vector<double> power(frameSize / 2 + 1, 0.0);
+    std::vector<std::complex<float>> buffer(frameSize);
+    for (size_t start = 0; start + frameSize <= signal.size(); start += hop) {
+        for (size_t i = 0; i < frameSize; ++i)
+            buffer[i] = std::complex<float>((signal[start + i] - stats.dc) * window[i], 0.f);
+        fft(buffer);
+        for (size_t k = 0; k < power.size(); ++k)
+            power[k] += std::norm(buffer[k]);
+    }
+
+    // Skip the DC bin, the flatness and centroid are about the tone
+    double binHz = sampleRate / frameSize;
+    double total = 0.0, weighted = 0.0, logSum = 0.0;
+    for (size_t k = 1; k < power.size(); ++k) {
+        total += power[k];
+        weighted += power[k] * k * binHz;
+        logSum += std::log(power[k] + 1e-20);
+    }
+    size_t bins = power.size() - 1;
+    if (total <= 0.0)
+        return stats;
+
+    stats.centroid = weighted / total;
+    stats.flatness = std::exp(logSum / bins) / (total / bins);
+    double cumulative = 0.0;
+    for (size_t k = 1; k < power.size(); ++k) {
+        cumulative += power[k];
+        if (cumulative >= 0.85 * total) {
+            stats.rolloff = k * binHz;
+            break;
+        }
+    }
+    return stats;
+}
+
+
+// Job indices [begin, end) owned by one worker, packed into one word so the
+// owner and thieves can both update it with a single CAS
+struct JobRange {
+    std::atomic<uint64_t> range{0};
+
+    static uint64_t pack(uint32_t begin, uint32_t end) {
+        return (uint64_t(end) << 32) | begin;
+    }
+
+    void set(uint32_t begin, uint32_t end) {
+        range.store(pack(begin, end));
+    }
+
+    // Owner side: take the next job from the front
+    bool pop(uint32_t& job) {
+        uint64_t r = range.load();
+        while (true) {
+            uint32_t begin = uint32_t(r), end = uint32_t(r >> 32);
+            if (begin >= end)
+                return false;
+            if (range.compare_exchange_weak(r, pack(begin + 1, end))) {
+                job = begin;
+                return true;
+            }
+        }
+    }
+
+    // Thief side: take the back half, leaving the front to the owner
+    bool steal(uint32_t& stolenBegin, uint32_t& stolenEnd) {
+        uint64_t r = range.load();
+        while (true) {
+            uint32_t begin = uint32_t(r), end = uint32_t(r >> 32);
+            if (begin >= end)
+                return false;
+            uint32_t mid = begin + (end - begin) / 2;
+            if (range.compare_exchange_weak(r, pack(begin, mid))) {
+                stolenBegin = mid;
+                stolenEnd = end;
+                return true;
+            }
+        }
+    }
+
+    uint32_t size() {
+        uint64_t r = range.load();
+        uint32_t begin = uint32_t(r), end = uint32_t(r >> 32);
+        return (begin < end) ? end - begin : 0;
+    }
+};
+
+struct Sweep {
+    const Settings& settings;
+    uint32_t jobCount = 1;
+    std::vector<JobRange> ranges;
+    FILE* csv = nullptr;
+    std::mutex csvMutex;
+    std::atomic<uint32_t> done{0};
+    std::atomic<uint32_t> failed{0};
+
+    explicit Sweep(const Settings& settings) : settings(settings), ranges(settings.threads) {
+        for (const Axis& axis : settings.axes)
+            jobCount *= axis.values.size();
+    }
+
+    // Mixed-radix decode of a job index into one value per axis, last axis fastest
+    std::vector<float> jobValues(uint32_t job) const {
+        std::vector<float> values(settings.axes.size());
+        for (size_t a = settings.axes.size(); a-- > 0;) {
+            const std::vector<float>& axisValues = settings.axes[a].values;
+            values[a] = axisValues[job % axisValues.size()];
+            job /= axisValues.size();
+        }
+        return values;
+    }
+
+    void render(uint32_t job, std::vector<float>& interleaved, std::vector<float>& mono) {
+        std::vector<float> values = jobValues(job);
+
+        FmOperator module;
+        for (const auto& fixed : settings.fixed)
+            fixed.first.apply(module, fixed.second);
+        for (size_t a = 0; a < settings.axes.size(); ++a)
+            settings.axes[a].target.apply(module, values[a]);
+        // Rendered outputs count as patched, the module may skip unpatched ones
+        for (int output : settings.outputs)
+            module.outputs[output].channels = 1;
+
+        size_t frames = static_cast<size_t>(settings.duration * settings.sampleRate);
+        size_t channels = settings.outputs.size();
+        interleaved.resize(frames * channels);
+        mono.resize(frames);
+
+        Module::ProcessArgs args;
+        args.sampleRate = settings.sampleRate;
+        args.sampleTime = 1.f / settings.sampleRate;
+        for (size_t i = 0; i < frames; ++i) {
+            args.frame = i;
+            module.process(args);
+            float sum = 0.f;
+            for (size_t c = 0; c < channels; ++c) {
+                // Rack's audio interfaces map +-10V to full scale
+                float v = module.outputs[settings.outputs[c]].getVoltage() / 10.f;
+                interleaved[i * channels + c] = v;
+                sum += v;
+            }
+            mono[i] = sum / channels;
+        }
+
+        char fileName[32];
+        std::snprintf(fileName, sizeof(fileName), "render_%06" PRIu32 ".wav", job);
+        if (settings.writeWav) {
+            std::string path = (std::filesystem::path(settings.outDir) / fileName).string();
+            if (!writeWav(path, interleaved, channels, static_cast<int>(settings.sampleRate))) {
+                std::fprintf(stderr, "Could not write %s\n", path.c_str());
+                failed++;
+            }
+        }
+
+        Stats stats = analyze(mono, settings.sampleRate);
+
+        std::string row = std::to_string(job);
+        for (float v : values)
+            row += "," + std::to_string(v);
+        row += std::string(",") + (settings.writeWav ? fileName : "");
+        char statsText[160];
+        std::snprintf(statsText, sizeof(statsText), ",%g,%g,%g,%g,%g,%g\n",
+            stats.rms, stats.peak, stats.dc, stats.centroid, stats.flatness, stats.rolloff);
+        row += statsText;
+
+        std::lock_guard<std::mutex> lock(csvMutex);
+        std::fputs(row.c_str(), csv);
+        done++;
+    }
+
+    void worker(int self) {
+        std::vector<float> interleaved, mono;
+        int count = static_cast<int>(ranges.size());
+        while (true) {
+            uint32_t job;
+            while (ranges[self].pop(job))
+                render(job, interleaved, mono);
+
+            // Out of work, steal from the victim with the most jobs left
+            int victim = -1;
+            uint32_t most = 0;
+            for (int i = 1; i < count; ++i) {
+                int other = (self + i) % count;
+                uint32_t size = ranges[other].size();
+                if (size > most) {
+                    most = size;
+                    victim = other;
+                }
+            }
+            if (victim < 0)
+                return;
+
+            uint32_t begin, end;
+            if (ranges[victim].steal(begin, end))
+                ranges[self].set(begin, end);
+        }
+    }
+
+    int run() {
+        std::error_code ec;
+        std::filesystem::create_directories(settings.outDir, ec);
+        if (ec) {
+            std::fprintf(stderr, "Could not create %s: %s\n", settings.outDir.c_str(), ec.message().c_str());
+            return 1;
+        }
+        std::string csvPath = (std::filesystem::path(settings.outDir) / "stats.csv").string();
+        csv = std::fopen(csvPath.c_str(), "w");
+        if (!csv) {
+            std::fprintf(stderr, "Could not write %s\n", csvPath.c_str());
+            return 1;
+        }
+        std::fputs("job", csv);
+        for (const Axis& axis : settings.axes)
+            std::fprintf(csv, ",%s", axis.target.name.c_str());
+        std::fputs(",file,rms,peak,dc,centroid_hz,flatness,rolloff_hz\n", csv);
+
+        // Even split up front, stealing evens out renders of uneven cost
+        uint32_t threads = ranges.size();
+        for (uint32_t t = 0; t < threads; ++t)
+            ranges[t].set(uint64_t(jobCount) * t / threads, uint64_t(jobCount) * (t + 1) / threads);
+
+        std::vector<std::thread> pool;
+        for (uint32_t t = 0; t < threads; ++t)
+            pool.emplace_back(&Sweep::worker, this, t);
+        for (std::thread& thread : pool)
+            thread.join();
+
+        std::fclose(csv);
+        std::fprintf(stderr, "Rendered %" PRIu32 " of %" PRIu32 " settings with %" PRIu32 " threads into %s\n",
+            done.load(), jobCount, threads, settings.outDir.c_str());
+        return (failed > 0) ? 1 : 0;
+    }
+};
+
+
+int main(int argc, char** argv) {
+    Settings settings;
+    if (!parseArgs(argc, argv, settings)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    Sweep sweep(settings);
+    return sweep.run();
+}